@@ -6,6 +6,9 @@
 #include <string.h>
 #include <time.h>
 // #include <unistd.h> // For getpid()
+#if defined(DEBUG) && defined(__linux__)
+#include <unistd.h> // sysconf, for the soak test's RSS sampling
+#endif
 
 // Conditions
 #ifdef CONSIDER_2
@@ -16,6 +19,11 @@
 #pragma message("NUM_CONSIDER is 1.")
 #endif
 
+// 每一步的搜索时间预算（微秒，按 clock() 计的 CPU 时间），见 findBestActionAnytime
+#ifndef MOVE_TIME_BUDGET_US
+#define MOVE_TIME_BUDGET_US 1000
+#endif
+
 #ifdef DEBUG
 #define DEBUG_MODE 1
 #pragma message("DEBUG is on")
@@ -24,6 +32,44 @@
 #pragma message("DEBUG is off")
 #endif
 
+#ifdef DEBUG
+// 调试构建中统计堆分配，供 soak 测试检查内存是否稳定
+static long long g_live_allocations = 0; // 尚未释放的分配数
+static long long g_total_allocations = 0; // 累计分配数
+
+static void* countedMalloc(size_t size)
+{
+    void* ptr = malloc(size);
+    if (ptr != NULL) {
+        g_live_allocations++;
+        g_total_allocations++;
+    }
+    return ptr;
+}
+
+static void* countedCalloc(size_t count, size_t size)
+{
+    void* ptr = calloc(count, size);
+    if (ptr != NULL) {
+        g_live_allocations++;
+        g_total_allocations++;
+    }
+    return ptr;
+}
+
+static void countedFree(void* ptr)
+{
+    if (ptr != NULL) {
+        g_live_allocations--;
+    }
+    free(ptr);
+}
+
+#define malloc(size) countedMalloc(size)
+#define calloc(count, size) countedCalloc(count, size)
+#define free(ptr) countedFree(ptr)
+#endif
+
 typedef struct {
     void* data; //
     size_t size; //
@@ -499,6 +545,15 @@ Board* BoardCopy(const Board* board)
     return new_board;
 }
 
+void BoardFree(Board* board)
+{
+    if (board == NULL) {
+        return;
+    }
+    GridFree(board->grid, &board->size);
+    free(board);
+}
+
 IntList* getFullLines(const Board* board);
 
 void extractFeatures(const Board* board_before_action, const BlockStatus* action_with_y_offset, Board** out_board_after_action_and_clear, int* out_game_over_flag, int* out_features)
@@ -570,7 +625,7 @@ void extractFeatures(const Board* board_before_action, const BlockStatus* action
         for (int x = 0; x < simulated_board->size.width; x++) {
             if (simulated_board->grid[y][x] != 0) {
                 *out_game_over_flag = 1;
-                // goto post_game_over_check; // Exit loops
+                BoardFree(simulated_board);
                 return;
             }
         }
@@ -606,77 +661,205 @@ void extractFeatures(const Board* board_before_action, const BlockStatus* action
     }
 }
 
-double assessmentTwoActions(Game* game, BlockStatus* action_1, BlockStatus* action_2, AssessmentModel* model)
+// ----- 跨步复用的搜索结果 -----
+
+#define PLY_SCORES_MAX_ROWS 32
+#define PLY_SCORES_MAX_WIDTH 32
+#define PLY_SCORES_MAX_ROTATIONS 4
+
+/*
+某个棋盘上一个方块所有放置的 simulateAction 分数。
+两步搜索在选中分支的棋盘上已经评估过下一个方块的每个放置，
+下一步的棋盘正是这个棋盘、当前方块正是这个方块，所以第一步的分数可以直接取用。
+*/
+typedef struct {
+    int valid;
+    unsigned int rows[PLY_SCORES_MAX_ROWS]; // 棋盘每行（含缓冲区）的占用位图，作为键
+    int grid_height;
+    const Block* block;
+    const AssessmentModel* model;
+    double scores[PLY_SCORES_MAX_ROTATIONS][PLY_SCORES_MAX_WIDTH]; // [旋转][x_offset]，NAN 表示未评估
+} PlyScores;
+
+typedef struct {
+    PlyScores tables[3];
+    PlyScores* previous; // 上一步选中分支的第二步分数，供本步的第一步复用
+    PlyScores* branch; // 正在评估的分支
+    PlyScores* best; // 本步目前最好的分支
+} SearchCache;
+
+static SearchCache g_search_cache = {
+    .previous = &g_search_cache.tables[0],
+    .branch = &g_search_cache.tables[1],
+    .best = &g_search_cache.tables[2]
+};
+
+/*
+棋盘一行的占用位图
+*/
+unsigned int boardRowBits(const Board* board, int y)
 {
-    double score_1 = -INFINITY;
-    double score_2 = -INFINITY;
+    unsigned int row = 0;
+    for (int x = 0; x < board->size.width; x++) {
+        if (board->grid[y][x] != 0) {
+            row |= 1u << x;
+        }
+    }
+    return row;
+}
 
-    int features_1_data[k_num_features];
-    int features_2_data[k_num_features];
+/*
+以 board 为键清空分数表；棋盘或方块超出表的大小时表保持无效
 
-    Board* board_after_step1 = NULL;
-    int game_over_step1 = 0;
+:return: 表是否可用
+*/
+int PlyScoresReset(PlyScores* table, const Board* board, const Block* block, const AssessmentModel* model)
+{
+    table->valid = 0;
+    int grid_height = board->size.height + 5;
+    if (block == NULL || grid_height > PLY_SCORES_MAX_ROWS || board->size.width > PLY_SCORES_MAX_WIDTH || block->rotations_count > PLY_SCORES_MAX_ROTATIONS) {
+        return 0;
+    }
+    for (int y = 0; y < grid_height; y++) {
+        table->rows[y] = boardRowBits(board, y);
+    }
+    table->grid_height = grid_height;
+    table->block = block;
+    table->model = model;
+    for (int r = 0; r < PLY_SCORES_MAX_ROTATIONS; r++) {
+        for (int x = 0; x < PLY_SCORES_MAX_WIDTH; x++) {
+            table->scores[r][x] = NAN;
+        }
+    }
+    table->valid = 1;
+    return 1;
+}
 
-    // Check actions
-    if (action_1 == NULL || action_1->rotation == NULL) {
-        return -INFINITY;
+/*
+判断分数表是否属于这个棋盘、方块和模型（逐行比较占用位图）
+*/
+int PlyScoresMatch(const PlyScores* table, const Board* board, const Block* block, const AssessmentModel* model)
+{
+    if (!table->valid || table->block != block || table->model != model || table->grid_height != board->size.height + 5) {
+        return 0;
     }
-    if (action_2 == NULL || action_2->rotation == NULL) {
-        return -INFINITY;
+    for (int y = 0; y < table->grid_height; y++) {
+        if (boardRowBits(board, y) != table->rows[y]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*
+:return: 动作在表中的分数位置；动作不属于表的方块时为 NULL
+*/
+double* PlyScoresAt(PlyScores* table, const BlockStatus* action)
+{
+    ptrdiff_t rotation = action->rotation - table->block->rotations;
+    if (rotation < 0 || rotation >= table->block->rotations_count || action->x_offset < 0 || action->x_offset >= PLY_SCORES_MAX_WIDTH) {
+        return NULL;
     }
+    return &table->scores[rotation][action->x_offset];
+}
 
-    // --- Step 1 ---
-    BlockStatus action_1_eval = *action_1;
-    action_1_eval.y_offset = INT_MAX;
-    int y_offset_1 = findYOffset(&game->board, &action_1_eval);
+/*
+模拟一次放置：计算落点、提取特征并评估
 
-    if (y_offset_1 == -1) {
+:param board: 放置前的棋盘
+:param action: 方块状态（y_offset 会重新计算）
+:param model: 评估模型
+:param out_board: 若不为 NULL，返回消除后的棋盘（由调用者 BoardFree）；非法时为 NULL
+:return: 评估分数；非法或导致游戏结束时为 -INFINITY
+*/
+double simulateAction(const Board* board, const BlockStatus* action, AssessmentModel* model, Board** out_board)
+{
+    if (out_board != NULL) {
+        *out_board = NULL;
+    }
+    if (action == NULL || action->rotation == NULL) {
         return -INFINITY;
     }
-    action_1_eval.y_offset = y_offset_1;
-
-    extractFeatures(&game->board, &action_1_eval, &board_after_step1, &game_over_step1, features_1_data);
 
-    if (game_over_step1 || board_after_step1 == NULL) {
-        if (board_after_step1) {
-            GridFree(board_after_step1->grid, &board_after_step1->size);
-            free(board_after_step1);
-        }
+    BlockStatus action_eval = *action;
+    action_eval.y_offset = INT_MAX;
+    int y_offset = findYOffset(board, &action_eval);
+    if (y_offset == -1) {
         return -INFINITY;
     }
-    score_1 = caculateLinearFunction(model->weights, features_1_data, k_num_features);
+    action_eval.y_offset = y_offset;
+
+    int features_data[k_num_features];
+    Board* board_after_action = NULL;
+    int game_over = 0;
 
-    // --- Step 2 ---
-    BlockStatus action_2_eval = *action_2;
-    action_2_eval.y_offset = INT_MAX; // Reset
-    int y_offset_2 = findYOffset(board_after_step1, &action_2_eval); // Use board_after_step1
+    extractFeatures(board, &action_eval, out_board != NULL ? &board_after_action : NULL, &game_over, features_data);
 
-    if (y_offset_2 == -1) {
-        GridFree(board_after_step1->grid, &board_after_step1->size);
-        free(board_after_step1);
+    if (game_over || (out_board != NULL && board_after_action == NULL)) {
+        BoardFree(board_after_action);
         return -INFINITY;
     }
-    action_2_eval.y_offset = y_offset_2;
 
-    int game_over_step2 = 0;
+    if (out_board != NULL) {
+        *out_board = board_after_action;
+    }
+    return caculateLinearFunction(model->weights, features_data, k_num_features);
+}
 
-    extractFeatures(board_after_step1, &action_2_eval, NULL, &game_over_step2, features_2_data);
+/*
+在第一步之后的棋盘上，评估所有第二步动作，返回最高分
+
+:param board_after_step1: 第一步放置并消除后的棋盘
+:param game: 游戏对象（使用 available_statuses_2）
+:param model: 评估模型
+:param out_scores: 若不为 NULL，记录每个第二步动作的分数（以 board_after_step1 为键）
+:return: 第二步的最高分；没有合法动作时为 -INFINITY
+*/
+double bestSecondActionScore(const Board* board_after_step1, Game* game, AssessmentModel* model, PlyScores* out_scores)
+{
+    if (out_scores != NULL && !PlyScoresReset(out_scores, board_after_step1, game->upcoming_blocks[1], model)) {
+        out_scores = NULL;
+    }
+    double best_score_2 = -INFINITY;
+    for (int j = 0; j < game->available_statuses_2_count; j++) {
+        double score_2 = simulateAction(board_after_step1, game->available_statuses_2[j], model, NULL);
+        if (out_scores != NULL) {
+            double* slot = PlyScoresAt(out_scores, game->available_statuses_2[j]);
+            if (slot != NULL) {
+                *slot = score_2;
+            }
+        }
+        if (score_2 > best_score_2) {
+            best_score_2 = score_2;
+        }
+    }
+    return best_score_2;
+}
 
-    // board_1 no longer needed
-    GridFree(board_after_step1->grid, &board_after_step1->size);
-    free(board_after_step1);
-    board_after_step1 = NULL;
+/*
+评估第一步动作及其之后最好的第二步：第一步只模拟一次，所有第二步都基于同一个棋盘
 
-    if (game_over_step2) {
+:param out_scores_2: 若不为 NULL，记录所有第二步的分数（见 bestSecondActionScore）；第一步非法时置为无效
+:return: 两步分数之和；第一步非法或没有合法的第二步时为 -INFINITY
+*/
+double assessmentTwoPly(Game* game, BlockStatus* action_1, AssessmentModel* model, PlyScores* out_scores_2)
+{
+    if (out_scores_2 != NULL) {
+        out_scores_2->valid = 0;
+    }
+    Board* board_after_step1 = NULL;
+    double score_1 = simulateAction(&game->board, action_1, model, &board_after_step1);
+    if (score_1 <= -INFINITY) {
         return -INFINITY;
     }
-    score_2 = caculateLinearFunction(model->weights, features_2_data, k_num_features);
 
-    if (score_1 <= -INFINITY || score_2 <= -INFINITY) {
+    double score_2 = bestSecondActionScore(board_after_step1, game, model, out_scores_2);
+    BoardFree(board_after_step1);
+
+    if (score_2 <= -INFINITY) {
         return -INFINITY;
     }
-
-    return score_1 + score_2; // success
+    return score_1 + score_2;
 }
 
 /*
@@ -952,6 +1135,7 @@ int executeAction(Game* game, BlockStatus* action, int eliminate)
     // eliminate
     IntList* full_lines = getFullLines(board);
     size_t num_full_lines = clearFullLines(board, full_lines);
+    IntListFree(full_lines);
 
     // add score
     if (num_full_lines > 0) {
@@ -1035,37 +1219,70 @@ BlockStatus** getAvailableActions(Game* game, Block* block)
 
 double assessmentSingleAction(Game* game, BlockStatus* action, AssessmentModel* model)
 {
-    if (action->rotation == NULL) {
-        return -INFINITY; // Invalid action
+    // 不需要放置后的棋盘，extractFeatures 会自行释放
+    return simulateAction(&game->board, action, model, NULL);
+}
+
+/*
+上一步留下的第二步分数表，与当前棋盘和方块匹配时返回，否则为 NULL
+*/
+PlyScores* reusableFirstPlyScores(Game* game, AssessmentModel* model)
+{
+    PlyScores* reuse = g_search_cache.previous;
+    if (!PlyScoresMatch(reuse, &game->board, game->upcoming_blocks[0], model)) {
+        return NULL;
     }
+    return reuse;
+}
 
-    BlockStatus current_action_eval = *action;
-    current_action_eval.y_offset = INT_MAX;
+/*
+第一步动作的分数：reuse 中有记录时直接取用，否则模拟
 
-    int y_offset = findYOffset(&game->board, &current_action_eval);
-    if (y_offset == -1) {
-        return -INFINITY; // Invalid action
+:param reuse: reusableFirstPlyScores 的结果，可为 NULL
+*/
+double assessmentFirstAction(Game* game, BlockStatus* action, AssessmentModel* model, PlyScores* reuse)
+{
+    double* cached = reuse != NULL ? PlyScoresAt(reuse, action) : NULL;
+    if (cached != NULL && !isnan(*cached)) {
+        return *cached;
     }
-    current_action_eval.y_offset = y_offset;
+    return assessmentSingleAction(game, action, model);
+}
 
-    int features_data[k_num_features];
-    Board* board_after_action = NULL;
-    int game_over = 0;
+/*
+刚评估的分支（g_search_cache.branch）成为目前最好的分支
+*/
+void keepSearchBranch(void)
+{
+    PlyScores* swap = g_search_cache.best;
+    g_search_cache.best = g_search_cache.branch;
+    g_search_cache.branch = swap;
+}
 
-    extractFeatures(&game->board, &current_action_eval, &board_after_action, &game_over, features_data);
+/*
+评估一个分支（assessmentTwoPly），它成为目前最好的分支时保留它的第二步分数
 
-    if (game_over) {
-        if (board_after_action) {
-            GridFree(board_after_action->grid, &board_after_action->size);
-            free(board_after_action);
-        }
-        return -INFINITY; // Invalid action
+:param best_combined_score: 目前最好分支的两步分数
+:return: 这个分支的两步分数
+*/
+double assessmentBranch(Game* game, BlockStatus* action_1, AssessmentModel* model, double best_combined_score)
+{
+    double combined_score = assessmentTwoPly(game, action_1, model, g_search_cache.branch);
+    if (combined_score > best_combined_score) {
+        keepSearchBranch();
     }
+    return combined_score;
+}
 
-    double current_score = caculateLinearFunction(model->weights, features_data, k_num_features);
-
-    return current_score;
-
+/*
+两步搜索结束：选中分支的第二步分数留给下一步（下一步的棋盘就是这个分支的棋盘）
+*/
+void commitSearchBranch(void)
+{
+    PlyScores* swap = g_search_cache.previous;
+    g_search_cache.previous = g_search_cache.best;
+    g_search_cache.best = swap;
+    g_search_cache.best->valid = 0;
 }
 
 BlockStatus* findBestSingleAction(Game* game, AssessmentModel* model)
@@ -1131,8 +1348,12 @@ BlockStatus* findBestActionV3(Game* game, AssessmentModel* model)
     int top_n = (int)(game->available_statuses_1_count * n / 100.0) + 1;
     double first_scores[game->available_statuses_1_count];
 
+    // 上一步已在这个棋盘上评估过这个方块的所有放置时，直接取用那些分数
+    PlyScores* reuse = reusableFirstPlyScores(game, model);
+    g_search_cache.best->valid = 0;
+
     for (int i = 0; i < game->available_statuses_1_count; i++) {
-        first_scores[i] = assessmentSingleAction(game, game->available_statuses_1[i], model);
+        first_scores[i] = assessmentFirstAction(game, game->available_statuses_1[i], model, reuse);
     }
 
     // 排序
@@ -1150,15 +1371,10 @@ BlockStatus* findBestActionV3(Game* game, AssessmentModel* model)
         }
     }
 
-    // 保留
+    // 保留前 top_n 个（actions_1 已按分数排序）
     if (top_n > game->available_statuses_1_count) {
         top_n = game->available_statuses_1_count;
     }
-    BlockStatus** top_actions_1 = (BlockStatus**)malloc(sizeof(BlockStatus*) * (top_n + 1));
-    for (int i = 0; i < top_n; i++) {
-        top_actions_1[i] = actions_1[i];
-    }
-    top_actions_1[top_n] = NULL; 
 
     for (int i = 0; i < top_n; i++) {
         BlockStatus* action_1 = actions_1[i];
@@ -1166,22 +1382,18 @@ BlockStatus* findBestActionV3(Game* game, AssessmentModel* model)
             continue;
         }
 
-        for (int j = 0; j < game->available_statuses_2_count; j++) {
-            BlockStatus* action_2 = game->available_statuses_2[j];
-            double combined_score = assessmentTwoActions(game, action_1, action_2, model);
-            if (combined_score > best_combined_score) {
-                best_combined_score = combined_score;
-                best_action = action_1;
-            }
+        double combined_score = assessmentBranch(game, action_1, model, best_combined_score);
+        if (combined_score > best_combined_score) {
+            best_combined_score = combined_score;
+            best_action = action_1;
         }
     }
 
+    commitSearchBranch();
     if (best_action == NULL) {
         return NULL;
     }
 
-    
-
     return best_action;
 }
 
@@ -1200,22 +1412,22 @@ BlockStatus* findBestAction(Game* game, AssessmentModel* model)
     BlockStatus** actions_1 = game->available_statuses_1;
     Block* block_2 = game->upcoming_blocks[1];
 
+    // 第一步的棋盘对每个 action_1 只模拟一次，再在其上枚举所有第二步
+    g_search_cache.best->valid = 0;
     for (int i = 0; i < game->available_statuses_1_count; i++) {
         BlockStatus* action_1 = actions_1[i];
         if (action_1->rotation == NULL) {
             continue;
         }
 
-        for (int j = 0; j < game->available_statuses_2_count; j++) {
-            BlockStatus* action_2 = game->available_statuses_2[j];
-            double combined_score = assessmentTwoActions(game, action_1, action_2, model);
-            if (combined_score > best_combined_score) {
-                best_combined_score = combined_score;
-                best_action = action_1;
-            }
+        double combined_score = assessmentBranch(game, action_1, model, best_combined_score);
+        if (combined_score > best_combined_score) {
+            best_combined_score = combined_score;
+            best_action = action_1;
         }
     }
 
+    commitSearchBranch();
     if (best_action == NULL) {
         return NULL;
     }
@@ -1223,6 +1435,81 @@ BlockStatus* findBestAction(Game* game, AssessmentModel* model)
     return best_action;
 }
 
+/*
+在截止时间前尽量深入地搜索（anytime）：
+1. 一步搜索：评估所有第一步（可复用上一步的第二步分数），得到第一个答案；
+2. 按第一步分数从高到低逐个展开两步分支：展开前 5% 即 V3 的剪枝两步搜索，全部展开即完整两步搜索。
+每展开一个分支前检查时间，到期时返回已展开分支中最好的答案（没有则用一步搜索的答案）。
+同分时取靠前的动作，所以时间充足时结果与 findBestAction 相同。
+
+:param game: 游戏对象
+:param model: 评估模型
+:param deadline: 截止时间（clock()）
+:return: 最佳的操作策略；没有合法动作时为 NULL
+*/
+BlockStatus* findBestActionAnytime(Game* game, AssessmentModel* model, clock_t deadline)
+{
+    BlockStatus** actions_1 = game->available_statuses_1;
+    int count = game->available_statuses_1_count;
+    g_search_cache.best->valid = 0;
+    if (count == 0) {
+        commitSearchBranch();
+        return NULL;
+    }
+
+    // 1. 一步搜索
+    PlyScores* reuse = reusableFirstPlyScores(game, model);
+    double first_scores[count];
+    int order[count];
+    BlockStatus* best_action = NULL;
+    double best_first_score = -INFINITY;
+    for (int i = 0; i < count; i++) {
+        first_scores[i] = assessmentFirstAction(game, actions_1[i], model, reuse);
+        order[i] = i;
+        if (first_scores[i] > best_first_score) {
+            best_first_score = first_scores[i];
+            best_action = actions_1[i];
+        }
+    }
+
+    // 按第一步分数降序插入排序，同分保持原顺序
+    for (int i = 1; i < count; i++) {
+        int current = order[i];
+        int j = i - 1;
+        while (j >= 0 && first_scores[order[j]] < first_scores[current]) {
+            order[j + 1] = order[j];
+            j--;
+        }
+        order[j + 1] = current;
+    }
+
+    // 2. 逐个展开两步分支
+    double best_combined_score = -INFINITY;
+    int best_index = -1;
+    for (int k = 0; k < count; k++) {
+        int i = order[k];
+        if (first_scores[i] <= -INFINITY) {
+            break; // 之后的第一步都不合法
+        }
+        if (clock() >= deadline) {
+            break;
+        }
+
+        double combined_score = assessmentTwoPly(game, actions_1[i], model, g_search_cache.branch);
+        if (combined_score > best_combined_score || (combined_score > -INFINITY && combined_score == best_combined_score && i < best_index)) {
+            best_combined_score = combined_score;
+            best_index = i;
+            keepSearchBranch();
+        }
+    }
+    if (best_index >= 0) {
+        best_action = actions_1[best_index];
+    }
+
+    commitSearchBranch();
+    return best_action;
+}
+
 void freeActionsArray(BlockStatus** actions, int count)
 {
     if (actions == NULL) {
@@ -1239,6 +1526,7 @@ void freeActionsArray(BlockStatus** actions, int count)
 //  upcoming_blocks[0] upcoming_blocks
 BlockStatus* runGameStep(Context* ctx, Block* next_block, int mode)
 {
+    clock_t step_start = clock();
     Game* game = ctx->game;
     AssessmentModel* model = ctx->model;
 
@@ -1304,6 +1592,9 @@ BlockStatus* runGameStep(Context* ctx, Block* next_block, int mode)
         best_action = findBestAction(game, model);
     } else if (mode == 3) {
         best_action = findBestActionV3(game, model);
+    } else if (mode == 4) {
+        clock_t budget = (clock_t)((double)MOVE_TIME_BUDGET_US * CLOCKS_PER_SEC / 1000000);
+        best_action = findBestActionAnytime(game, model, step_start + budget);
     } else {
         fprintf(stderr, "Invalid mode: %d\n", mode);
         return NULL; // Invalid mode
@@ -1415,6 +1706,111 @@ void runRandomTest(Context* ctx, int mode)
     ctx->game->available_statuses_2_count = 0;
 }
 
+#ifdef DEBUG
+/*
+读取当前进程的常驻内存 (KiB)，不支持时返回 -1
+*/
+long readResidentKiB(void)
+{
+#ifdef __linux__
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (statm == NULL) {
+        return -1;
+    }
+    long size_pages = 0, resident_pages = 0;
+    int read = fscanf(statm, "%ld %ld", &size_pages, &resident_pages);
+    fclose(statm);
+    if (read != 2) {
+        return -1;
+    }
+    return resident_pages * (sysconf(_SC_PAGESIZE) / 1024);
+#else
+    return -1;
+#endif
+}
+
+/*
+长时间运行测试：连续放置 total_pieces 个方块（游戏结束则清空棋盘继续），
+每 interval 个方块采样一次常驻内存和堆分配数。
+除去当前一步持有的动作数组后，存活的分配数必须保持不变，常驻内存的增长不得超过 1 MiB。
+
+:return: 0 表示内存稳定，1 表示检测到增长
+*/
+int runSoakTest(Context* ctx, size_t total_pieces, size_t interval, int mode)
+{
+    Game* game = ctx->game;
+    const long rss_tolerance_kib = 1024;
+
+    srand(1); // 固定序列，便于复现
+    game->upcoming_blocks[0] = randomBlock();
+    game->upcoming_blocks[1] = randomBlock();
+
+    long long baseline_allocations = -1;
+    long baseline_rss = -1;
+    int games = 1;
+    int failed = 0;
+
+    for (size_t piece = 1; piece <= total_pieces; piece++) {
+        BlockStatus* action_taken = runGameStep(ctx, piece == 1 ? NULL : randomBlock(), mode);
+        if (action_taken != NULL) {
+            free(action_taken);
+        } else {
+            // 游戏结束：清空棋盘，开始新的一局
+            for (int y = 0; y < game->board.size.height + 5; y++) {
+                memset(game->board.grid[y], 0, game->board.size.width * sizeof(short));
+            }
+            game->score = 0;
+            games++;
+        }
+
+        if (piece % interval != 0 && piece != total_pieces) {
+            continue;
+        }
+
+        // 当前一步的动作数组在下一步开始时才释放，不计入
+        long long held = 0;
+        if (game->available_statuses_1 != NULL) {
+            held += 1 + game->available_statuses_1_count;
+        }
+        if (game->available_statuses_2 != NULL) {
+            held += 1 + game->available_statuses_2_count;
+        }
+        long long steady_allocations = g_live_allocations - held;
+        long rss = readResidentKiB();
+        if (baseline_allocations < 0) {
+            baseline_allocations = steady_allocations;
+            baseline_rss = rss;
+        }
+
+        printf("Soak: pieces=%zu games=%d live_allocs=%lld total_allocs=%lld rss_kib=%ld\n",
+            piece, games, steady_allocations, g_total_allocations, rss);
+        fflush(stdout);
+
+        if (steady_allocations != baseline_allocations) {
+            fprintf(stderr, "Soak: live allocations changed from %lld to %lld\n", baseline_allocations, steady_allocations);
+            failed = 1;
+        }
+        if (rss >= 0 && baseline_rss >= 0 && rss > baseline_rss + rss_tolerance_kib) {
+            fprintf(stderr, "Soak: RSS grew from %ld KiB to %ld KiB\n", baseline_rss, rss);
+            failed = 1;
+        }
+        if (failed) {
+            break;
+        }
+    }
+
+    freeActionsArray(game->available_statuses_1, game->available_statuses_1_count);
+    game->available_statuses_1 = NULL;
+    game->available_statuses_1_count = 0;
+    freeActionsArray(game->available_statuses_2, game->available_statuses_2_count);
+    game->available_statuses_2 = NULL;
+    game->available_statuses_2_count = 0;
+
+    printf("Soak %s\n", failed ? "FAILED" : "PASSED");
+    return failed;
+}
+#endif
+
 const Block* findBlock(char name)
 {
     for (int i = 0; i < k_blocks_count; i++) {
@@ -1487,7 +1883,24 @@ int main(int argc, char* argv[])
         runRandomTest(&ctx, 1);
     } else if (strcmp(argv[1], "double") == 0) {
         runRandomTest(&ctx, 2);
-    } else if (!DEBUG_MODE || strcmp(argv[1], "oj") == 0) {
+    } else if (strcmp(argv[1], "anytime") == 0) {
+        runRandomTest(&ctx, 4);
+    }
+#ifdef DEBUG
+    // soak [pieces] [interval] [mode]
+    else if (strcmp(argv[1], "soak") == 0) {
+        size_t total_pieces = argc > 2 ? (size_t)strtoull(argv[2], NULL, 10) : 10000000;
+        size_t interval = argc > 3 ? (size_t)strtoull(argv[3], NULL, 10) : 100000;
+        int mode = argc > 4 ? atoi(argv[4]) : 1;
+        if (interval == 0) {
+            interval = 1;
+        }
+        int soak_failed = runSoakTest(&ctx, total_pieces, interval, mode);
+        GridFree(game.board.grid, &game.board.size);
+        return soak_failed;
+    }
+#endif
+    else if (!DEBUG_MODE || strcmp(argv[1], "oj") == 0) {
         // {
     oj:;
         char b1 = 0, b2 = 0;
@@ -1533,15 +1946,14 @@ int main(int argc, char* argv[])
                     break;
                 }
 
-                const int change_to_2 = 100000;
-
                 // if (ctx.game->score < 0 || ctx.game->score > 1000000) { // check game over before next step
                 //     // printf("%ld\n", labs(ctx.game->score));
                 //     // fflush(stdout);
                 //     return 0;
                 // }
                 // printf("CURRENT Upcoming: %c, %c\n", game->upcoming_blocks[0]->name, game->upcoming_blocks[1]->name);
-                action_taken = runGameStep(&ctx, findBlock(b1), i >= change_to_2 ? 2 : 3);
+                // 每一步在 MOVE_TIME_BUDGET_US 内尽量做完整的两步搜索
+                action_taken = runGameStep(&ctx, findBlock(b1), 4);
                 // action_taken = runGameStep(&ctx, findBlock(b1), 3);
                 if (action_taken) {
                     printf("%d %d\n%ld\n", degreeToNo(action_taken->rotation->label), action_taken->x_offset, labs(ctx.game->score));
@@ -0,0 +1,250 @@
+"""
+train_cpp 引擎（libtetris，C 接口见 train_cpp/c_api.h）的 ctypes 绑定
+
+所有结果都直接写入 numpy 数组的缓冲区，不做额外拷贝。库的位置取环境变量 TETRIS_LIB，
+默认为 train_cpp/build/libtetris.so（cmake -S train_cpp -B train_cpp/build 后构建）。
+"""
+
+import ctypes
+import os
+
+import numpy as np
+
+_DEFAULT_LIB = os.path.join(os.path.dirname(__file__), "..", "train_cpp", "build", "libtetris.so")
+
+API_VERSION = 2
+
+
+class TetrisError(RuntimeError):
+    """
+    libtetris 调用失败
+    """
+
+
+class Action(ctypes.Structure):
+    """
+    一个落点，对应 tetris_action
+    """
+
+    _fields_ = [("x", ctypes.c_int32), ("rotation", ctypes.c_int32), ("landing_row", ctypes.c_int32)]
+
+
+_f64_array = np.ctypeslib.ndpointer(dtype=np.float64, flags="C_CONTIGUOUS")
+_i32_array = np.ctypeslib.ndpointer(dtype=np.int32, flags="C_CONTIGUOUS")
+_i64_array = np.ctypeslib.ndpointer(dtype=np.int64, flags="C_CONTIGUOUS")
+_u32_array = np.ctypeslib.ndpointer(dtype=np.uint32, flags="C_CONTIGUOUS")
+
+
+def _nullable(array_type):
+    """
+    允许传入 None 的 ndpointer 参数类型
+    """
+
+    class Nullable(array_type):
+        @classmethod
+        def from_param(cls, obj):
+            return None if obj is None else array_type.from_param(obj)
+
+    return Nullable
+
+
+def _load(path: str) -> ctypes.CDLL:
+    """
+    加载库并声明函数签名
+
+    :param path: libtetris.so 的路径
+    :return: 加载好的库
+    """
+    lib = ctypes.CDLL(path)
+    game_p = ctypes.c_void_p
+    signatures = {
+        "tetris_api_version": (ctypes.c_int, []),
+        "tetris_last_error": (ctypes.c_char_p, []),
+        "tetris_board_width": (ctypes.c_int, []),
+        "tetris_board_height": (ctypes.c_int, []),
+        "tetris_num_features": (ctypes.c_int, []),
+        "tetris_feature_name": (ctypes.c_char_p, [ctypes.c_int]),
+        "tetris_max_actions": (ctypes.c_int, []),
+        "tetris_game_create": (game_p, [ctypes.c_uint32]),
+        "tetris_game_destroy": (None, [game_p]),
+        "tetris_game_is_over": (ctypes.c_int, [game_p]),
+        "tetris_game_score": (ctypes.c_int, [game_p]),
+        "tetris_game_steps": (ctypes.c_int64, [game_p]),
+        "tetris_game_pieces": (ctypes.c_int, [game_p, ctypes.POINTER(ctypes.c_int32), ctypes.POINTER(ctypes.c_int32)]),
+        "tetris_game_board": (ctypes.c_int, [game_p, _nullable(_u32_array), ctypes.c_int]),
+        "tetris_game_evaluate": (
+            ctypes.c_int,
+            [game_p, _f64_array, ctypes.c_int, ctypes.POINTER(Action), _nullable(_i32_array), _nullable(_f64_array), ctypes.c_int],
+        ),
+        "tetris_game_play": (ctypes.c_int, [game_p, ctypes.c_int32, ctypes.c_int32]),
+        "tetris_game_step": (ctypes.c_int, [game_p, _f64_array, ctypes.c_int, ctypes.POINTER(Action)]),
+        "tetris_run_games": (
+            ctypes.c_int,
+            [_f64_array, ctypes.c_int, _u32_array, ctypes.c_int, ctypes.c_int, _nullable(_i64_array), _nullable(_i32_array)],
+        ),
+    }
+    for name, (restype, argtypes) in signatures.items():
+        func = getattr(lib, name)
+        func.restype = restype
+        func.argtypes = argtypes
+    if lib.tetris_api_version() != API_VERSION:
+        raise TetrisError(f"{path} 的接口版本为 {lib.tetris_api_version()}，需要 {API_VERSION}")
+    return lib
+
+
+_lib = None
+
+
+def lib() -> ctypes.CDLL:
+    """
+    第一次使用时加载 libtetris
+
+    :return: 加载好的库
+    """
+    global _lib
+    if _lib is None:
+        _lib = _load(os.environ.get("TETRIS_LIB", _DEFAULT_LIB))
+    return _lib
+
+
+def available() -> bool:
+    """
+    :return: libtetris 能否加载
+    """
+    try:
+        lib()
+    except (OSError, TetrisError):
+        return False
+    return True
+
+
+def _check(result: int) -> int:
+    """
+    把 TETRIS_ERROR 转成异常
+
+    :param result: C 函数的返回值
+    :return: 原返回值
+    """
+    if result < 0:
+        raise TetrisError(lib().tetris_last_error().decode())
+    return result
+
+
+def _weights(weights) -> np.ndarray:
+    return np.ascontiguousarray(weights, dtype=np.float64)
+
+
+def feature_names() -> list[str]:
+    """
+    :return: 特征名，weights[i] 对应第 i 个特征
+    """
+    return [lib().tetris_feature_name(i).decode() for i in range(lib().tetris_num_features())]
+
+
+class CppGame:
+    """
+    一局由 C++ 引擎运行的游戏，方块序列由 seed 决定
+    """
+
+    def __init__(self, seed: int = 0):
+        self._handle = lib().tetris_game_create(seed)
+        if not self._handle:
+            raise TetrisError(lib().tetris_last_error().decode())
+        self._capacity = lib().tetris_max_actions()
+        self._actions = (Action * self._capacity)()
+        self._scores = np.empty(self._capacity, dtype=np.float64)
+        rows = _check(lib().tetris_game_board(self._handle, None, 0))  # 含隐藏缓冲行
+        self._rows = np.empty(rows, dtype=np.uint32)
+
+    def __del__(self):
+        if getattr(self, "_handle", None):
+            lib().tetris_game_destroy(self._handle)
+            self._handle = None
+
+    @property
+    def is_over(self) -> bool:
+        return bool(_check(lib().tetris_game_is_over(self._handle)))
+
+    @property
+    def score(self) -> int:
+        return lib().tetris_game_score(self._handle)
+
+    @property
+    def steps(self) -> int:
+        return lib().tetris_game_steps(self._handle)
+
+    def pieces(self) -> tuple[int, int]:
+        """
+        :return: (当前方块, 下一个方块) 在 I, T, O, J, L, S, Z 中的下标
+        """
+        current, upcoming = ctypes.c_int32(), ctypes.c_int32()
+        _check(lib().tetris_game_pieces(self._handle, ctypes.byref(current), ctypes.byref(upcoming)))
+        return current.value, upcoming.value
+
+    def board(self) -> np.ndarray:
+        """
+        :return: 每行的占用位掩码（第 x 位表示第 x 列），第 0 行在最下面，含隐藏缓冲行
+        """
+        count = _check(lib().tetris_game_board(self._handle, self._rows, len(self._rows)))
+        return self._rows[:count].copy()
+
+    def evaluate(self, weights, with_features: bool = False):
+        """
+        批量评估当前方块的所有落点
+
+        :param weights: 权重，weights[i] 对应 feature_names()[i]
+        :param with_features: 是否同时返回特征矩阵
+        :return: (落点列表 [(x, rotation, landing_row)], 得分数组[, 特征矩阵 num_weights x n])
+        """
+        w = _weights(weights)
+        features = np.empty((len(w), self._capacity), dtype=np.int32) if with_features else None
+        n = _check(lib().tetris_game_evaluate(self._handle, w, len(w), self._actions, features, self._scores, self._capacity))
+        actions = [(a.x, a.rotation, a.landing_row) for a in self._actions[:n]]
+        if with_features:
+            return actions, self._scores[:n].copy(), features[:, :n]
+        return actions, self._scores[:n].copy()
+
+    def play(self, x: int, rotation: int) -> bool:
+        """
+        在指定落点放下当前方块
+
+        :return: 游戏是否还能继续
+        """
+        return bool(_check(lib().tetris_game_play(self._handle, x, rotation)))
+
+    def step(self, weights) -> bool:
+        """
+        用给定权重选出最佳落点并放下当前方块
+
+        :return: 游戏是否还能继续
+        """
+        w = _weights(weights)
+        return bool(_check(lib().tetris_game_step(self._handle, w, len(w), None)))
+
+
+def run_games(weights, seeds, num_threads: int = 1) -> tuple[np.ndarray, np.ndarray]:
+    """
+    用同一组权重完整地跑多局游戏
+
+    :param weights: 权重
+    :param seeds: 每局的方块序列种子
+    :param num_threads: C++ 端的线程数
+    :return: (每局放下的方块数, 每局得分)
+    """
+    w = _weights(weights)
+    seeds = np.ascontiguousarray(seeds, dtype=np.uint32)
+    steps = np.empty(len(seeds), dtype=np.int64)
+    scores = np.empty(len(seeds), dtype=np.int32)
+    _check(lib().tetris_run_games(w, len(w), seeds, len(seeds), num_threads, steps, scores))
+    return steps, scores
+
+
+def run_game_for_training(weights: list[float]) -> int:
+    """
+    game.run_game_for_training 的 C++ 版本：只用前 8 个特征，方块序列随机
+
+    :param weights: 权重列表
+    :return: 游戏得分
+    """
+    _, scores = run_games(weights[:8], [np.random.randint(0, 2**32, dtype=np.uint64)])
+    return abs(int(scores[0]))
@@ -1,6 +1,7 @@
 import numpy as np
 from game import MyDbtFeatureExtractor, create_new_game, run_game, run_game_for_training
 from models import AssessmentModel, Context, Strategy
+import tetris_cpp # libtetris 的 ctypes 绑定，可用时代替纯 Python 引擎
 from icecream import ic
 import logging
 import concurrent.futures # Added import
@@ -44,6 +45,8 @@ def run_single_game(params: list[float]):
     # 这里你需要实现游戏逻辑
     # 使用 params 来评估游戏状态
     # 返回得分
+    if tetris_cpp.available():
+        return tetris_cpp.run_game_for_training(params)
     return run_game_for_training(params)
 
 # --- 模拟游戏的函数 (你需要实现这个！) ---
@@ -0,0 +1,178 @@
+#include "affinity.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <dirent.h>
+
+PinMode parsePinMode(const std::string& name)
+{
+    if (name == "none") return PinMode::None;
+    if (name == "core") return PinMode::Core;
+    if (name == "node") return PinMode::Node;
+    throw std::invalid_argument("Unknown pin mode '" + name + "' (expected none, core or node)");
+}
+
+const char* pinModeName(PinMode mode)
+{
+    switch (mode) {
+    case PinMode::Core: return "core";
+    case PinMode::Node: return "node";
+    default: return "none";
+    }
+}
+
+namespace {
+
+int parseCpuNumber(const std::string& text, const std::string& list)
+{
+    char* end = nullptr;
+    errno = 0;
+    long value = std::strtol(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0' || errno != 0 || value < 0 || value >= CPU_SETSIZE) {
+        throw std::invalid_argument("Invalid CPU list '" + list + "'");
+    }
+    return static_cast<int>(value);
+}
+
+} // namespace
+
+std::vector<int> parseCpuList(const std::string& list)
+{
+    std::vector<int> cpus;
+    std::istringstream in(list);
+    std::string range;
+    while (std::getline(in, range, ',')) {
+        while (!range.empty() && (range.back() == '\n' || range.back() == ' ')) range.pop_back();
+        if (range.empty()) continue;
+        size_t dash = range.find('-');
+        int first = parseCpuNumber(range.substr(0, dash), list);
+        int last = dash == std::string::npos ? first : parseCpuNumber(range.substr(dash + 1), list);
+        if (last < first) {
+            throw std::invalid_argument("Invalid CPU list '" + list + "'");
+        }
+        for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+    }
+    if (cpus.empty()) {
+        throw std::invalid_argument("Empty CPU list '" + list + "'");
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+std::string formatCpuList(const std::vector<int>& cpus)
+{
+    std::ostringstream out;
+    for (size_t i = 0; i < cpus.size();) {
+        size_t j = i;
+        while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) ++j;
+        if (i > 0) out << ',';
+        out << cpus[i];
+        if (j > i) out << '-' << cpus[j];
+        i = j + 1;
+    }
+    return out.str();
+}
+
+std::vector<int> allowedCpus()
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    std::vector<int> cpus;
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        return cpus;
+    }
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &set)) cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+std::vector<int> cpuNodes(const std::vector<int>& cpus)
+{
+    std::vector<int> nodes(cpus.size(), 0);
+    const std::string root = "/sys/devices/system/node";
+    DIR* dir = opendir(root.c_str());
+    if (!dir) {
+        return nodes;
+    }
+    while (dirent* entry = readdir(dir)) {
+        const char* name = entry->d_name;
+        if (std::strncmp(name, "node", 4) != 0 || name[4] < '0' || name[4] > '9') continue;
+        int node = std::atoi(name + 4);
+        std::ifstream file(root + "/" + name + "/cpulist");
+        std::string list;
+        if (!std::getline(file, list) || list.empty()) continue; // Memory-only node
+        std::vector<int> node_cpus;
+        try {
+            node_cpus = parseCpuList(list);
+        } catch (const std::invalid_argument&) {
+            continue;
+        }
+        for (size_t i = 0; i < cpus.size(); ++i) {
+            if (std::binary_search(node_cpus.begin(), node_cpus.end(), cpus[i])) nodes[i] = node;
+        }
+    }
+    closedir(dir);
+    return nodes;
+}
+
+CpuPlacement::CpuPlacement(std::vector<int> cpus, PinMode mode)
+    : cpus_(std::move(cpus))
+    , mode_(mode)
+{
+    if (cpus_.empty()) {
+        throw std::invalid_argument("CpuPlacement needs at least one CPU");
+    }
+    std::sort(cpus_.begin(), cpus_.end());
+    nodes_ = cpuNodes(cpus_);
+
+    // CPUs of each node, then dealt one per node per round
+    std::map<int, std::vector<int>> by_node;
+    for (size_t i = 0; i < cpus_.size(); ++i) by_node[nodes_[i]].push_back(static_cast<int>(i));
+    num_nodes_ = static_cast<int>(by_node.size());
+    for (size_t round = 0; slot_order_.size() < cpus_.size(); ++round) {
+        for (const auto& node : by_node) {
+            if (round < node.second.size()) slot_order_.push_back(node.second[round]);
+        }
+    }
+}
+
+cpu_set_t CpuPlacement::mask(int slot) const
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    int index = slot_order_[static_cast<size_t>(slot) % slot_order_.size()];
+    for (size_t i = 0; i < cpus_.size(); ++i) {
+        bool use = mode_ == PinMode::None
+            || (mode_ == PinMode::Core && static_cast<int>(i) == index)
+            || (mode_ == PinMode::Node && nodes_[i] == nodes_[index]);
+        if (use) CPU_SET(cpus_[i], &set);
+    }
+    return set;
+}
+
+std::string CpuPlacement::describe(int slot) const
+{
+    int index = slot_order_[static_cast<size_t>(slot) % slot_order_.size()];
+    switch (mode_) {
+    case PinMode::Core:
+        return "cpu " + std::to_string(cpus_[index]) + " (node " + std::to_string(nodes_[index]) + ")";
+    case PinMode::Node:
+        return "node " + std::to_string(nodes_[index]);
+    default:
+        return "cpus " + formatCpuList(cpus_);
+    }
+}
+
+bool CpuPlacement::pinCurrentThread(int slot) const
+{
+    cpu_set_t set = mask(slot);
+    return sched_setaffinity(0, sizeof(set), &set) == 0; // 0: the calling thread
+}
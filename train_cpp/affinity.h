@@ -0,0 +1,62 @@
+#ifndef AFFINITY_H
+#define AFFINITY_H
+
+#include <sched.h>
+#include <string>
+#include <vector>
+
+// How evaluation threads (and locally spawned worker processes) are placed on CPUs
+enum class PinMode {
+    None, // Every thread may run on any CPU of the set
+    Core, // Thread k is pinned to one CPU
+    Node, // Thread k is pinned to the CPUs of one NUMA node
+};
+
+// "none", "core" or "node"; throws std::invalid_argument otherwise
+PinMode parsePinMode(const std::string& name);
+const char* pinModeName(PinMode mode);
+
+// Parses a Linux CPU list such as "0-15,32-47" into sorted, unique CPU numbers.
+// Throws std::invalid_argument if it is malformed, empty or names a CPU >= CPU_SETSIZE.
+std::vector<int> parseCpuList(const std::string& list);
+std::string formatCpuList(const std::vector<int>& cpus);
+
+// CPUs the calling process may run on (sched_getaffinity)
+std::vector<int> allowedCpus();
+
+// NUMA node of each CPU in `cpus`, from /sys/devices/system/node/node*/cpulist.
+// Every CPU is on node 0 if the kernel exposes no NUMA topology.
+std::vector<int> cpuNodes(const std::vector<int>& cpus);
+
+// Affinity masks for numbered slots (evaluation threads or worker processes).
+// Slots are dealt round-robin over the NUMA nodes of the set and then over the CPUs of
+// each node, so any number of slots spreads evenly over the nodes. Slots past the number
+// of CPUs wrap around.
+//
+// Memory follows the CPU on Linux (first-touch): a thread that pins itself before creating
+// its game state, scratch pools and thread_local buffers gets them on its local node.
+class CpuPlacement {
+public:
+    // Throws std::invalid_argument if `cpus` is empty
+    CpuPlacement(std::vector<int> cpus, PinMode mode);
+
+    PinMode mode() const { return mode_; }
+    const std::vector<int>& cpus() const { return cpus_; }
+    int numNodes() const { return num_nodes_; }
+
+    cpu_set_t mask(int slot) const;
+    std::string describe(int slot) const; // For logging, e.g. "cpu 5 (node 1)"
+
+    // Applies mask(slot) to the calling thread. Returns false (errno set) if the kernel
+    // refuses, e.g. a CPU outside the cgroup's cpuset.
+    bool pinCurrentThread(int slot) const;
+
+private:
+    std::vector<int> cpus_;       // Sorted
+    std::vector<int> nodes_;      // Node of cpus_[i]
+    std::vector<int> slot_order_; // Index into cpus_ of slot k (mod size)
+    int num_nodes_ = 1;
+    PinMode mode_;
+};
+
+#endif // AFFINITY_H
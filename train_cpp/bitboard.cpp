@@ -0,0 +1,403 @@
+#include "bitboard.h"
+#include "models.h"
+#include <algorithm> // For std::copy, std::fill, std::max
+#include <stdexcept>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define TETRIS_HAVE_AVX2_KERNELS 1
+#include <immintrin.h>
+#else
+#define TETRIS_HAVE_AVX2_KERNELS 0
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define TETRIS_ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define TETRIS_ALWAYS_INLINE inline
+#endif
+
+void loadBitRows(const Board& board, BitRows& out)
+{
+    int grid_height = board.getGridHeight();
+    if (board.size.width > k_max_board_width || grid_height > k_max_grid_rows) {
+        throw std::invalid_argument("Board too large for row-mask kernels.");
+    }
+    out.width = board.size.width;
+    out.height = board.size.height;
+    out.grid_height = grid_height;
+    std::copy(board.row_masks.begin(), board.row_masks.begin() + grid_height, out.rows.begin());
+    std::fill(out.rows.begin() + grid_height, out.rows.end(), RowMask(0));
+}
+
+void columnTops(const BitRows& bits, std::array<int, k_max_board_width>& tops)
+{
+    tops.fill(0);
+    RowMask found = 0;
+    const RowMask full = fullRowMask(bits.width);
+    for (int y = bits.grid_height - 1; y >= 0 && found != full; --y) {
+        RowMask fresh = bits.rows[y] & ~found;
+        while (fresh) {
+            tops[lowestBit32(fresh)] = y + 1;
+            fresh &= fresh - 1;
+        }
+        found |= bits.rows[y];
+    }
+}
+
+PiecePlacement makePiecePlacement(const BlockRotation& rotation, int x_offset, int y_offset)
+{
+    PiecePlacement piece;
+    piece.y = y_offset;
+    for (const auto& pos : rotation.occupied) {
+        if (pos.y < 0 || pos.y >= k_max_piece_rows) {
+            throw std::logic_error("Block rotation taller than k_max_piece_rows.");
+        }
+        piece.rows[pos.y] |= RowMask(1) << (x_offset + pos.x);
+        piece.height = std::max(piece.height, pos.y + 1);
+    }
+    return piece;
+}
+
+int applyPlacement(BitRows& bits, const PiecePlacement& piece)
+{
+    const RowMask full = fullRowMask(bits.width);
+    std::uint64_t cleared_rows = 0;
+    int num_cleared = 0;
+    int lowest_cleared = -1;
+    for (int k = 0; k < piece.height; ++k) {
+        int y = piece.y + k;
+        bits.rows[y] |= piece.rows[k];
+        if (y < bits.height && (bits.rows[y] & full) == full) {
+            cleared_rows |= std::uint64_t(1) << y;
+            num_cleared++;
+            if (lowest_cleared == -1) lowest_cleared = y;
+        }
+    }
+    if (num_cleared == 0) {
+        return 0;
+    }
+
+    int write_y = lowest_cleared;
+    for (int read_y = lowest_cleared; read_y < bits.grid_height; ++read_y) {
+        if (!((cleared_rows >> read_y) & 1)) {
+            bits.rows[write_y++] = bits.rows[read_y];
+        }
+    }
+    std::fill(bits.rows.begin() + write_y, bits.rows.begin() + bits.grid_height, RowMask(0));
+    return num_cleared;
+}
+
+bool hasBlocksInBuffer(const BitRows& bits)
+{
+    for (int y = bits.height; y < bits.grid_height; ++y) {
+        if (bits.rows[y] != 0) return true;
+    }
+    return false;
+}
+
+int PlacementOverlay::place(const PiecePlacement& piece)
+{
+    lift();
+    piece_ = piece;
+    cleared_rows_ = 0;
+    eroded_cells_ = 0;
+
+    const RowMask full = fullRowMask(base_.width);
+    int num_cleared = 0;
+    int piece_cells_cleared = 0;
+    for (int k = 0; k < piece.height; ++k) {
+        int y = piece.y + k;
+        base_.rows[y] |= piece.rows[k];
+        if (y < base_.height && (base_.rows[y] & full) == full) {
+            cleared_rows_ |= std::uint64_t(1) << y;
+            num_cleared++;
+            piece_cells_cleared += popcount32(piece.rows[k]);
+        }
+    }
+    in_base_ = true;
+    if (num_cleared == 0) {
+        return 0; // Common case: the view is just the base rows plus the piece cells
+    }
+    eroded_cells_ = num_cleared * piece_cells_cleared;
+
+    // Compact the surviving rows; rows below the lowest cleared one are unchanged
+    scratch_.width = base_.width;
+    scratch_.height = base_.height;
+    scratch_.grid_height = base_.grid_height;
+    int write_y = 0;
+    for (int read_y = 0; read_y < base_.grid_height; ++read_y) {
+        if (!((cleared_rows_ >> read_y) & 1)) {
+            scratch_.rows[write_y++] = base_.rows[read_y];
+        }
+    }
+    std::fill(scratch_.rows.begin() + write_y, scratch_.rows.end(), RowMask(0));
+    lift();
+    return num_cleared;
+}
+
+void PlacementOverlay::lift()
+{
+    if (!in_base_) return;
+    for (int k = 0; k < piece_.height; ++k) {
+        base_.rows[piece_.y + k] &= ~piece_.rows[k];
+    }
+    in_base_ = false;
+}
+
+void countHoles(const BitRows& bits, int& holes, int& hole_depth, int& rows_with_holes)
+{
+    holes = 0;
+    hole_depth = 0;
+    rows_with_holes = 0;
+    const RowMask full = fullRowMask(bits.width);
+    RowMask covered = 0;
+    ColumnCounters blocks_above;
+    for (int y = bits.grid_height - 2; y >= 0; --y) {
+        RowMask row = bits.rows[y];
+        if (y < bits.height) {
+            RowMask hole_cells = covered & ~row & full;
+            if (hole_cells) {
+                holes += popcount32(hole_cells);
+                rows_with_holes++;
+                hole_depth += blocks_above.sum(hole_cells);
+            }
+        }
+        covered |= row;
+        blocks_above.increment(row);
+    }
+}
+
+int countWells(const BitRows& bits)
+{
+    if (bits.width <= 0) return 0;
+    const RowMask full = fullRowMask(bits.width);
+    const RowMask left_wall = RowMask(1);
+    const RowMask right_wall = RowMask(1) << (bits.width - 1);
+    int wells_sum = 0;
+    ColumnCounters run_length;
+    for (int y = bits.height - 1; y >= 0; --y) {
+        RowMask row = bits.rows[y];
+        RowMask well = ~row & full & ((row << 1) | left_wall) & ((row >> 1) | right_wall);
+        run_length.retain(well);
+        if (well) {
+            run_length.increment(well);
+            wells_sum += run_length.sum(well);
+        }
+    }
+    return wells_sum;
+}
+
+// --- Portable kernels ---
+
+namespace {
+
+int rowTransitionsPortable(const BitRows& bits)
+{
+    if (bits.width < 2) return 0;
+    const RowMask inner = fullRowMask(bits.width - 1);
+    int transitions = 0;
+    for (int y = 0; y < bits.height; ++y) {
+        RowMask row = bits.rows[y];
+        transitions += popcount32((row ^ (row >> 1)) & inner);
+    }
+    return transitions;
+}
+
+int columnTransitionsPortable(const BitRows& bits)
+{
+    const RowMask full = fullRowMask(bits.width);
+    int transitions = 0;
+    for (int y = 0; y < bits.height - 1; ++y) {
+        transitions += popcount32((bits.rows[y] ^ bits.rows[y + 1]) & full);
+    }
+    return transitions;
+}
+
+// --- AVX2 kernels: 8 rows per iteration ---
+
+#if TETRIS_HAVE_AVX2_KERNELS
+
+// Per-byte popcount via a nibble lookup table (AVX2 has no vector popcnt)
+__attribute__((target("avx2"))) inline __m256i popcountBytesAvx2(__m256i v)
+{
+    const __m256i lut = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+        0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    const __m256i low_nibbles = _mm256_set1_epi8(0x0f);
+    __m256i lo = _mm256_and_si256(v, low_nibbles);
+    __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), low_nibbles);
+    return _mm256_add_epi8(_mm256_shuffle_epi8(lut, lo), _mm256_shuffle_epi8(lut, hi));
+}
+
+// Sums the byte counters accumulated by popcountBytesAvx2
+__attribute__((target("avx2"))) inline int horizontalByteSumAvx2(__m256i byte_counts)
+{
+    __m256i sums = _mm256_sad_epu8(byte_counts, _mm256_setzero_si256());
+    return static_cast<int>(_mm256_extract_epi64(sums, 0) + _mm256_extract_epi64(sums, 1)
+        + _mm256_extract_epi64(sums, 2) + _mm256_extract_epi64(sums, 3));
+}
+
+// All-ones in the lanes whose row index (base + lane) is below `limit`
+__attribute__((target("avx2"))) inline __m256i laneMaskAvx2(int base, int limit)
+{
+    const __m256i lane_index = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    return _mm256_cmpgt_epi32(_mm256_set1_epi32(limit - base), lane_index);
+}
+
+// Byte counters hold at most 8 per iteration; k_max_grid_rows / 8 iterations stay far below 255.
+__attribute__((target("avx2"))) int rowTransitionsAvx2(const BitRows& bits)
+{
+    if (bits.width < 2) return 0;
+    const __m256i inner = _mm256_set1_epi32(static_cast<int>(fullRowMask(bits.width - 1)));
+    __m256i counts = _mm256_setzero_si256();
+    for (int y = 0; y < bits.height; y += 8) {
+        __m256i rows = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bits.rows.data() + y));
+        __m256i changes = _mm256_xor_si256(rows, _mm256_srli_epi32(rows, 1));
+        changes = _mm256_and_si256(_mm256_and_si256(changes, inner), laneMaskAvx2(y, bits.height));
+        counts = _mm256_add_epi8(counts, popcountBytesAvx2(changes));
+    }
+    return horizontalByteSumAvx2(counts);
+}
+
+__attribute__((target("avx2"))) int columnTransitionsAvx2(const BitRows& bits)
+{
+    const __m256i full = _mm256_set1_epi32(static_cast<int>(fullRowMask(bits.width)));
+    __m256i counts = _mm256_setzero_si256();
+    for (int y = 0; y < bits.height - 1; y += 8) {
+        __m256i lower = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bits.rows.data() + y));
+        __m256i upper = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(bits.rows.data() + y + 1));
+        __m256i changes = _mm256_and_si256(_mm256_xor_si256(lower, upper), full);
+        changes = _mm256_and_si256(changes, laneMaskAvx2(y, bits.height - 1));
+        counts = _mm256_add_epi8(counts, popcountBytesAvx2(changes));
+    }
+    return horizontalByteSumAvx2(counts);
+}
+
+#endif // TETRIS_HAVE_AVX2_KERNELS
+
+// --- Fused fixed-shape kernel ---
+// One walk from grid_height - 2 down to 0 computes every BoardFeatures field. All bounds are
+// compile-time constants, so the loop unrolls and the whole board stays in registers.
+template <class Shape>
+TETRIS_ALWAYS_INLINE void boardFeaturesFixed(const RowMask* rows, BoardFeatures& out)
+{
+    constexpr RowMask full = (RowMask(1) << Shape::width) - 1;
+    constexpr RowMask inner = (RowMask(1) << (Shape::width - 1)) - 1;
+    constexpr RowMask left_wall = RowMask(1);
+    constexpr RowMask right_wall = RowMask(1) << (Shape::width - 1);
+
+    BoardFeatures f;
+    RowMask covered = 0;
+    ColumnCounters blocks_above;
+    ColumnCounters well_run;
+    for (int y = Shape::grid_height - 2; y >= 0; --y) {
+        const RowMask row = rows[y];
+        if (y < Shape::height) {
+            RowMask hole_cells = covered & ~row & full;
+            if (hole_cells) {
+                f.holes += popcount32(hole_cells);
+                f.rows_with_holes++;
+                f.hole_depth += blocks_above.sum(hole_cells);
+            }
+
+            RowMask well = ~row & full & ((row << 1) | left_wall) & ((row >> 1) | right_wall);
+            well_run.retain(well);
+            if (well) {
+                well_run.increment(well);
+                f.board_wells += well_run.sum(well);
+            }
+
+            f.row_transitions += popcount32((row ^ (row >> 1)) & inner);
+            if (y < Shape::height - 1) {
+                f.column_transitions += popcount32((row ^ rows[y + 1]) & full);
+            }
+        }
+        covered |= row;
+        blocks_above.increment(row);
+    }
+    out = f;
+}
+
+template <class Shape>
+void boardFeaturesPortable(const BitRows& bits, BoardFeatures& out)
+{
+    boardFeaturesFixed<Shape>(bits.rows.data(), out);
+}
+
+#if TETRIS_HAVE_AVX2_KERNELS
+// Same body compiled for AVX2 + hardware popcnt
+template <class Shape>
+__attribute__((target("avx2,popcnt"))) void boardFeaturesAvx2(const BitRows& bits, BoardFeatures& out)
+{
+    boardFeaturesFixed<Shape>(bits.rows.data(), out);
+}
+#endif
+
+// --- Runtime dispatch ---
+
+using BoardFeaturesKernel = void (*)(const BitRows&, BoardFeatures&);
+
+struct KernelSet {
+    int (*row_transitions)(const BitRows&);
+    int (*column_transitions)(const BitRows&);
+    BoardFeaturesKernel training_board; // TrainingBoardShape
+    BoardFeaturesKernel oj_board;       // OjBoardShape
+    const char* name;
+};
+
+KernelSet selectKernels()
+{
+#if TETRIS_HAVE_AVX2_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+        return { rowTransitionsAvx2, columnTransitionsAvx2,
+            boardFeaturesAvx2<TrainingBoardShape>, boardFeaturesAvx2<OjBoardShape>, "avx2" };
+    }
+#endif
+    return { rowTransitionsPortable, columnTransitionsPortable,
+        boardFeaturesPortable<TrainingBoardShape>, boardFeaturesPortable<OjBoardShape>, "portable" };
+}
+
+const KernelSet& kernels()
+{
+    static const KernelSet selected = selectKernels(); // Thread-safe one-time init
+    return selected;
+}
+
+template <class Shape>
+bool hasShape(const BitRows& bits)
+{
+    return bits.width == Shape::width && bits.height == Shape::height && bits.grid_height == Shape::grid_height;
+}
+
+} // namespace
+
+int countRowTransitions(const BitRows& bits)
+{
+    return kernels().row_transitions(bits);
+}
+
+int countColumnTransitions(const BitRows& bits)
+{
+    return kernels().column_transitions(bits);
+}
+
+void computeBoardFeatures(const BitRows& bits, BoardFeatures& out)
+{
+    const KernelSet& set = kernels();
+    if (hasShape<TrainingBoardShape>(bits)) {
+        set.training_board(bits, out);
+    } else if (hasShape<OjBoardShape>(bits)) {
+        set.oj_board(bits, out);
+    } else {
+        // Dynamic fallback for any other board size
+        out.row_transitions = set.row_transitions(bits);
+        out.column_transitions = set.column_transitions(bits);
+        countHoles(bits, out.holes, out.hole_depth, out.rows_with_holes);
+        out.board_wells = countWells(bits);
+    }
+}
+
+const char* bitboardKernelName()
+{
+    return kernels().name;
+}
@@ -0,0 +1,209 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include "models.h" // Board::k_buffer_height
+#include <array>
+#include <cstdint>
+
+// --- Row-mask board representation ---
+// Bit x of rows[y] is set when cell (x, y) is occupied (y = 0 is the bottom row).
+// Feature kernels work on these masks instead of chasing Block pointers cell by cell.
+
+using RowMask = std::uint32_t;
+
+constexpr int k_max_board_width = 32;
+constexpr int k_max_grid_rows = 64; // Logical height + buffer rows; Board accepts the same
+// Zero padding so SIMD kernels can always load 8 rows (+1 for the row above)
+// without reading past the array.
+constexpr int k_bit_rows_padding = 9;
+
+struct BitRows {
+    std::array<RowMask, k_max_grid_rows + k_bit_rows_padding> rows {};
+    int width = 0;       // Logical width
+    int height = 0;      // Logical height
+    int grid_height = 0; // Height including the buffer rows
+};
+
+// Builds the row masks of `board`. Rows at or above grid_height are zero.
+// Throws std::invalid_argument if the board exceeds k_max_board_width / k_max_grid_rows.
+void loadBitRows(const Board& board, BitRows& out);
+
+inline RowMask fullRowMask(int width)
+{
+    return width >= 32 ? ~RowMask(0) : ((RowMask(1) << width) - 1);
+}
+
+inline int popcount32(std::uint32_t v)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcount(v);
+#else
+    v = v - ((v >> 1) & 0x55555555u);
+    v = (v & 0x33333333u) + ((v >> 2) & 0x33333333u);
+    return static_cast<int>((((v + (v >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24);
+#endif
+}
+
+// Index of the lowest set bit; `v` must be non-zero
+inline int lowestBit32(std::uint32_t v)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctz(v);
+#else
+    int index = 0;
+    while (!(v & 1u)) {
+        v >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
+
+// Per-column counters stored bit-sliced: bit x of planes[k] is bit k of column x's count,
+// so one call updates every column at once.
+struct ColumnCounters {
+    static constexpr int k_planes = 7; // Counts up to 127 >= k_max_grid_rows
+    std::array<RowMask, k_planes> planes {};
+
+    // Adds 1 to every column whose bit is set in `columns` (ripple-carry across planes)
+    void increment(RowMask columns)
+    {
+        RowMask carry = columns;
+        for (int k = 0; k < k_planes && carry; ++k) {
+            RowMask next_carry = planes[k] & carry;
+            planes[k] ^= carry;
+            carry = next_carry;
+        }
+    }
+    // Resets every column whose bit is clear in `keep`
+    void retain(RowMask keep)
+    {
+        for (auto& plane : planes) plane &= keep;
+    }
+    // Sum of the counts of the columns selected by `columns`
+    int sum(RowMask columns) const
+    {
+        int total = 0;
+        for (int k = 0; k < k_planes; ++k) total += popcount32(planes[k] & columns) << k;
+        return total;
+    }
+};
+static_assert((1 << ColumnCounters::k_planes) > k_max_grid_rows, "ColumnCounters too narrow for the grid");
+
+// Number of filled/empty changes between horizontally adjacent cells in rows [0, height)
+// (walls are not counted): sum of popcount((row ^ (row >> 1)) & inner_mask).
+int countRowTransitions(const BitRows& bits);
+
+// Number of filled/empty changes between vertically adjacent cells in rows [0, height):
+// sum of popcount(rows[y] ^ rows[y + 1]) for y < height - 1.
+int countColumnTransitions(const BitRows& bits);
+
+// Holes = empty cells in rows [0, height) with a filled cell somewhere above them in the
+// same column (scanning down from grid_height - 2, buffer rows included). Uses a running
+// "covered" mask (OR of the rows above) and bit-sliced per-column block counts:
+//   holes           += popcount(covered & ~row)
+//   rows_with_holes += (covered & ~row) != 0
+//   hole_depth      += blocks above each hole, summed over the hole columns
+void countHoles(const BitRows& bits, int& holes, int& hole_depth, int& rows_with_holes);
+
+// Wells over rows [0, height): a well cell is empty with both neighbours filled (or a wall),
+//   well = ~row & (row << 1 | left_wall) & (row >> 1 | right_wall).
+// A vertical run of r well cells contributes r * (r + 1) / 2, accumulated top-down as the
+// running run length of each well column (bit-sliced, reset where the run breaks).
+int countWells(const BitRows& bits);
+
+// Height of the topmost block in every column over the whole grid (0 = empty column),
+// i.e. the lowest row a piece cell may occupy in that column.
+void columnTops(const BitRows& bits, std::array<int, k_max_board_width>& tops);
+
+// --- Placement overlay ---
+// A piece laid over the base rows: rows[k] is the piece's mask in board row y + k.
+constexpr int k_max_piece_rows = 4;
+
+struct PiecePlacement {
+    std::array<RowMask, k_max_piece_rows> rows {};
+    int y = 0;      // Board row of rows[0]
+    int height = 0; // Number of rows used
+};
+
+// Masks of `rotation` placed at (x_offset, y_offset). Throws std::logic_error if the
+// rotation is taller than k_max_piece_rows; the caller checks the horizontal bounds.
+PiecePlacement makePiecePlacement(const BlockRotation& rotation, int x_offset, int y_offset);
+
+// Lays `piece` on the rows for good and clears the rows it completes (like eliminateLines()
+// on a Board). Returns the number of cleared rows.
+int applyPlacement(BitRows& bits, const PiecePlacement& piece);
+
+// True if any block sits in the buffer rows above the logical height (game over)
+bool hasBlocksInBuffer(const BitRows& bits);
+
+// View of "base rows + placed piece - cleared rows" without copying the Board.
+// place() ORs the piece into the base rows; only when it completes lines are the surviving
+// rows compacted into a scratch copy (and the base restored right away). lift() / the
+// destructor take the piece back out, so one overlay can be reused for every candidate.
+class PlacementOverlay {
+public:
+    explicit PlacementOverlay(BitRows& base)
+        : base_(base)
+    {
+    }
+    ~PlacementOverlay() { lift(); }
+    PlacementOverlay(const PlacementOverlay&) = delete;
+    PlacementOverlay& operator=(const PlacementOverlay&) = delete;
+
+    // Lays `piece` (which must not overlap the base) over the rows. Returns the number of
+    // rows it completes; only rows the piece touches are checked.
+    int place(const PiecePlacement& piece);
+    // Takes the piece back out of the base rows (no-op if nothing is placed).
+    void lift();
+
+    // The resulting board, valid until the next place() / lift()
+    const BitRows& rows() const { return cleared_rows_ ? scratch_ : base_; }
+    // Bit y set if board row y was cleared by the last place()
+    std::uint64_t clearedRows() const { return cleared_rows_; }
+    // Piece cells removed by the cleared rows
+    int erodedPieceCells() const { return eroded_cells_; }
+
+private:
+    BitRows& base_;
+    BitRows scratch_;
+    PiecePlacement piece_;
+    std::uint64_t cleared_rows_ = 0;
+    int eroded_cells_ = 0;
+    bool in_base_ = false; // Piece currently ORed into base_
+};
+
+// --- Compile-time board shapes ---
+// The fused kernel below is a template on the board dimensions so that its row loops have
+// constant trip counts and fully unroll. Explicit instantiations exist for the shapes we
+// actually run; any other size goes through the runtime-sized count* kernels above.
+template <int Width, int Height>
+struct BoardShape {
+    static_assert(Width > 0 && Width <= k_max_board_width, "Unsupported board width");
+    static_assert(Height > 0 && Height + Board::k_buffer_height <= k_max_grid_rows, "Unsupported board height");
+    static constexpr int width = Width;
+    static constexpr int height = Height;
+    static constexpr int grid_height = Height + Board::k_buffer_height;
+};
+
+using TrainingBoardShape = BoardShape<10, 14>; // createNewGame()
+using OjBoardShape = BoardShape<10, 16>;       // oj_version/
+
+// The six post-elimination DBT features that only depend on the board
+struct BoardFeatures {
+    int row_transitions = 0;
+    int column_transitions = 0;
+    int holes = 0;
+    int hole_depth = 0;
+    int rows_with_holes = 0;
+    int board_wells = 0;
+};
+
+// Computes all BoardFeatures in one top-down pass over the rows, dispatching on the
+// dimensions of `bits` (10x14, 10x16, else dynamic) and on the CPU (avx2/popcnt or portable).
+void computeBoardFeatures(const BitRows& bits, BoardFeatures& out);
+
+// Name of the kernel set picked at runtime ("avx2" or "portable").
+const char* bitboardKernelName();
+
+#endif // BITBOARD_H
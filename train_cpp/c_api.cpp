@@ -0,0 +1,384 @@
+#include "c_api.h"
+#include "constants.h"
+#include "extractor.h"
+#include "game.h"
+#include "game_state.h"
+#include "models.h"
+#include "trace.h" // traceBlockIndex
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Handle behind tetris_game*: the game plus its own piece generator, swapped into the
+// thread's generator (pieceGenerator()) while the game draws pieces
+struct tetris_game {
+    Game game;
+    std::mt19937 rng;
+    std::int64_t steps = 0;
+
+    tetris_game(Game g, std::uint32_t seed)
+        : game(std::move(g))
+        , rng(seed)
+    {
+    }
+};
+
+static_assert(sizeof(int) == sizeof(int32_t), "FeatureBatch columns are copied into int32_t buffers");
+
+namespace {
+
+thread_local std::string g_last_error;
+
+// Runs `body` and turns any exception into TETRIS_ERROR plus tetris_last_error()
+template <class Body>
+auto guarded(Body&& body) -> decltype(body())
+{
+    try {
+        return body();
+    } catch (const std::exception& e) {
+        g_last_error = e.what();
+    } catch (...) {
+        g_last_error = "Unknown error";
+    }
+    return TETRIS_ERROR;
+}
+
+const char* const k_core_feature_names[MyDbtFeatureExtractorCpp::k_num_core_features] = {
+    "landing_height", "eroded_piece_cells", "row_transitions", "column_transitions",
+    "holes", "board_wells", "hole_depth", "rows_with_holes",
+};
+
+int boardWidth()
+{
+    static const int width = createNewGame().board.size.width;
+    return width;
+}
+
+// Names in extractFeatures() order, built once
+const std::vector<std::string>& featureNames()
+{
+    static const std::vector<std::string> names = [] {
+        const int width = boardWidth();
+        std::vector<std::string> out(std::begin(k_core_feature_names), std::end(k_core_feature_names));
+        for (int x = 0; x < width; ++x) out.push_back("column_height_" + std::to_string(x));
+        for (int x = 0; x + 1 < width; ++x) out.push_back("height_diff_" + std::to_string(x));
+        out.push_back("maximum_height");
+        return out;
+    }();
+    return names;
+}
+
+// Throws std::invalid_argument unless weights[0..num_weights) is a valid model
+AssessmentModel makeModel(const double* weights, int num_weights)
+{
+    if (!weights || num_weights < 1 || num_weights > MyDbtFeatureExtractorCpp::numFeatures(boardWidth())) {
+        throw std::invalid_argument("num_weights must be between 1 and tetris_num_features()");
+    }
+    return AssessmentModel(num_weights, std::vector<double>(weights, weights + num_weights),
+        std::make_unique<MyDbtFeatureExtractorCpp>());
+}
+
+void checkGame(const tetris_game* game)
+{
+    if (!game) {
+        throw std::invalid_argument("Null tetris_game");
+    }
+}
+
+// Swaps the game's generator into pieceGenerator() for the lifetime of the guard
+class PieceGeneratorSwap {
+public:
+    explicit PieceGeneratorSwap(tetris_game& game)
+        : game_(game)
+    {
+        std::swap(pieceGenerator(), game_.rng);
+    }
+    ~PieceGeneratorSwap() { std::swap(pieceGenerator(), game_.rng); }
+    PieceGeneratorSwap(const PieceGeneratorSwap&) = delete;
+    PieceGeneratorSwap& operator=(const PieceGeneratorSwap&) = delete;
+
+private:
+    tetris_game& game_;
+};
+
+int rotationIndex(const BlockStatus& action)
+{
+    const Block* block = getBlockFromRotation(action.rotation);
+    return block ? static_cast<int>(action.rotation - block->rotations.data()) : -1;
+}
+
+// Places `action` like runGame does. Returns 1 if the game goes on, 0 if it ended;
+// `landing_row` receives executeAction()'s result (-1 if the piece could not be placed).
+int playAction(tetris_game& handle, const BlockStatus& action, int& landing_row)
+{
+    PieceGeneratorSwap swap(handle);
+    landing_row = -1;
+    try {
+        landing_row = executeAction(handle.game, action);
+    } catch (const std::runtime_error&) {
+        if (!handle.game.isEnd()) throw;
+        return 0; // Overflow: the game is over
+    }
+    handle.steps++;
+    return handle.game.isEnd() ? 0 : 1;
+}
+
+const Block& currentBlock(const tetris_game& handle)
+{
+    if (handle.game.isEnd()) {
+        throw std::logic_error("The game is over");
+    }
+    return *handle.game.upcoming_blocks[0];
+}
+
+} // namespace
+
+extern "C" {
+
+int tetris_api_version(void)
+{
+    return TETRIS_API_VERSION;
+}
+
+const char* tetris_last_error(void)
+{
+    return g_last_error.c_str();
+}
+
+int tetris_board_width(void)
+{
+    return guarded([] { return boardWidth(); });
+}
+
+int tetris_board_height(void)
+{
+    return guarded([] { return createNewGame().board.size.height; });
+}
+
+int tetris_num_features(void)
+{
+    return guarded([] { return MyDbtFeatureExtractorCpp::numFeatures(boardWidth()); });
+}
+
+const char* tetris_feature_name(int index)
+{
+    const char* name = nullptr;
+    guarded([&] {
+        const auto& names = featureNames();
+        if (index >= 0 && index < static_cast<int>(names.size())) name = names[index].c_str();
+        return TETRIS_OK;
+    });
+    return name;
+}
+
+int tetris_max_actions(void)
+{
+    return guarded([] {
+        int most = 0;
+        for (const Block* block : k_blocks) {
+            most = std::max(most, static_cast<int>(getAllActions(*block, boardWidth()).size()));
+        }
+        return most;
+    });
+}
+
+tetris_game* tetris_game_create(uint32_t seed)
+{
+    tetris_game* handle = nullptr;
+    guarded([&] {
+        auto created = std::make_unique<tetris_game>(createNewGame(), seed);
+        {
+            PieceGeneratorSwap swap(*created);
+            created->game.upcoming_blocks = getNewUpcoming(created->game);
+        }
+        handle = created.release();
+        return TETRIS_OK;
+    });
+    return handle;
+}
+
+void tetris_game_destroy(tetris_game* game)
+{
+    delete game;
+}
+
+int tetris_game_is_over(const tetris_game* game)
+{
+    return guarded([&] {
+        checkGame(game);
+        return game->game.isEnd() ? 1 : 0;
+    });
+}
+
+int tetris_game_score(const tetris_game* game)
+{
+    return guarded([&] {
+        checkGame(game);
+        return game->game.score;
+    });
+}
+
+int64_t tetris_game_steps(const tetris_game* game)
+{
+    return guarded([&] {
+        checkGame(game);
+        return game->steps;
+    });
+}
+
+int tetris_game_pieces(const tetris_game* game, int32_t* current, int32_t* next)
+{
+    return guarded([&] {
+        checkGame(game);
+        const auto& upcoming = game->game.upcoming_blocks;
+        if (current) *current = upcoming.size() > 0 ? traceBlockIndex(upcoming[0]) : -1;
+        if (next) *next = upcoming.size() > 1 ? traceBlockIndex(upcoming[1]) : -1;
+        return TETRIS_OK;
+    });
+}
+
+int tetris_game_board(const tetris_game* game, uint32_t* rows, int capacity)
+{
+    return guarded([&] {
+        checkGame(game);
+        const auto& masks = game->game.board.row_masks;
+        const int count = static_cast<int>(masks.size());
+        if (!rows && capacity == 0) {
+            return count; // Size query
+        }
+        if (!rows || capacity < count) {
+            throw std::invalid_argument("Board buffer holds fewer rows than the grid");
+        }
+        std::copy(masks.begin(), masks.end(), rows);
+        return count;
+    });
+}
+
+int tetris_game_evaluate(const tetris_game* game, const double* weights, int num_weights,
+    tetris_action* actions, int32_t* features, double* scores, int capacity)
+{
+    return guarded([&] {
+        checkGame(game);
+        const AssessmentModel model = makeModel(weights, num_weights);
+        const std::vector<BlockStatus> candidates = getAllActions(currentBlock(*game), game->game.board.size.width);
+        const int count = static_cast<int>(candidates.size());
+        if (capacity < count) {
+            throw std::invalid_argument("Buffers hold fewer placements than the current piece has");
+        }
+
+        // Thread-local scratch, reused across calls like the search's
+        thread_local FeatureBatch batch;
+        thread_local PlacementBatch placements;
+        thread_local std::vector<double> batch_scores;
+        // Every feature if the caller wants them, otherwise only the weighted ones
+        const FeatureMask mask = features ? k_all_features : model.featureMask();
+        model.feature_extractor->extractFeaturesBatch(game->game, candidates, num_weights, mask, batch,
+            actions ? &placements : nullptr);
+        scoreFeatureBatch(model.weights, batch, batch_scores);
+
+        for (int i = 0; i < count; ++i) {
+            if (actions) {
+                actions[i].x = candidates[i].x_offset;
+                actions[i].rotation = rotationIndex(candidates[i]);
+                actions[i].landing_row = placements.landing_rows[i];
+            }
+            if (scores) scores[i] = batch_scores[i];
+        }
+        if (features) {
+            for (int f = 0; f < num_weights; ++f) {
+                std::memcpy(features + static_cast<size_t>(f) * capacity, batch.column(f), sizeof(int32_t) * count);
+            }
+        }
+        return count;
+    });
+}
+
+int tetris_game_play(tetris_game* game, int32_t x, int32_t rotation)
+{
+    return guarded([&] {
+        checkGame(game);
+        const Block& block = currentBlock(*game);
+        if (rotation < 0 || rotation >= static_cast<int>(block.rotations.size())) {
+            throw std::invalid_argument("No such rotation of the current piece");
+        }
+        const BlockRotation& rot = block.rotations[rotation];
+        if (x < 0 || x > game->game.board.size.width - rot.size.width) {
+            throw std::invalid_argument("Placement outside the board");
+        }
+        int landing_row = -1;
+        return playAction(*game, BlockStatus(x, &rot), landing_row);
+    });
+}
+
+int tetris_game_step(tetris_game* game, const double* weights, int num_weights, tetris_action* move)
+{
+    return guarded([&] {
+        checkGame(game);
+        const AssessmentModel model = makeModel(weights, num_weights);
+        const std::vector<BlockStatus> candidates = getAllActions(currentBlock(*game), game->game.board.size.width);
+        std::optional<BlockStatus> best;
+        try {
+            best = findBestAction(game->game, candidates, model);
+        } catch (const std::runtime_error&) {
+            game->game.setEnd(); // No placement keeps the game going
+            return 0;
+        }
+        int landing_row = -1;
+        int result = playAction(*game, *best, landing_row);
+        if (move) {
+            move->x = best->x_offset;
+            move->rotation = rotationIndex(*best);
+            move->landing_row = landing_row;
+        }
+        return result;
+    });
+}
+
+int tetris_run_games(const double* weights, int num_weights, const uint32_t* seeds, int num_games,
+    int num_threads, int64_t* steps, int32_t* scores)
+{
+    return guarded([&] {
+        makeModel(weights, num_weights); // Validates the arguments before any thread starts
+        if (num_games < 0 || (num_games > 0 && !seeds)) {
+            throw std::invalid_argument("Invalid seeds");
+        }
+
+        std::atomic<int> next { 0 };
+        std::exception_ptr error;
+        std::atomic<bool> failed { false };
+        // Each thread seeds its own piece generator, so game g is the same on any thread
+        auto play = [&] {
+            try {
+                for (int g = next++; g < num_games && !failed; g = next++) {
+                    seedPieceGenerator(seeds[g]);
+                    Strategy strategy(std::make_unique<AssessmentModel>(makeModel(weights, num_weights)));
+                    Context ctx(createNewGame(), std::move(strategy));
+                    int played = runGame(ctx);
+                    if (steps) steps[g] = played;
+                    if (scores) scores[g] = ctx.game.score;
+                }
+            } catch (...) {
+                if (!failed.exchange(true)) error = std::current_exception();
+            }
+        };
+
+        const int count = std::min(std::max(num_threads, 1), std::max(num_games, 1));
+        std::vector<std::thread> threads;
+        for (int t = 1; t < count; ++t) threads.emplace_back(play);
+        play();
+        for (auto& thread : threads) thread.join();
+        if (error) std::rethrow_exception(error);
+        return TETRIS_OK;
+    });
+}
+
+} // extern "C"
@@ -0,0 +1,99 @@
+#ifndef TETRIS_C_API_H
+#define TETRIS_C_API_H
+
+/* --- C ABI of libtetris ---
+ * Plain C so the engine can be loaded with ctypes / cffi (see train/tetris_cpp.py).
+ * Every function fills caller-provided buffers and never keeps a pointer to them, and no
+ * C++ exception crosses the boundary: failures return TETRIS_ERROR (or NULL) and
+ * tetris_last_error() describes the last one on the calling thread.
+ *
+ * Weights: weights[i] scores feature i in the order of tetris_feature_name(); the model
+ * uses the first num_weights features (1 <= num_weights <= tetris_num_features()).
+ * Pieces are indices into the engine's block table (I, T, O, J, L, S, Z); a rotation is an
+ * index into that piece's rotations.
+ *
+ * Thread safety: a tetris_game may only be used by one thread at a time; different games
+ * and tetris_run_games() calls can run concurrently (ctypes releases the GIL). */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__)
+#define TETRIS_API __attribute__((visibility("default")))
+#else
+#define TETRIS_API
+#endif
+
+/* Bumped whenever a signature or struct below changes */
+#define TETRIS_API_VERSION 2
+
+#define TETRIS_OK 0
+#define TETRIS_ERROR (-1)
+
+typedef struct tetris_game tetris_game;
+
+/* One placement of the current piece */
+typedef struct tetris_action {
+    int32_t x;           /* Column of the rotation's left edge */
+    int32_t rotation;    /* Index into the piece's rotations */
+    int32_t landing_row; /* Row the piece lands on (0 = bottom), -1 if it cannot be placed */
+} tetris_action;
+
+TETRIS_API int tetris_api_version(void);
+/* Message of the last failed call on this thread, "" if none */
+TETRIS_API const char* tetris_last_error(void);
+
+TETRIS_API int tetris_board_width(void);
+TETRIS_API int tetris_board_height(void);
+TETRIS_API int tetris_num_features(void);
+/* NULL if index is out of range */
+TETRIS_API const char* tetris_feature_name(int index);
+/* Upper bound on the placements of any piece, for sizing tetris_game_evaluate() buffers */
+TETRIS_API int tetris_max_actions(void);
+
+/* New game whose piece sequence is fixed by `seed`. NULL on failure. */
+TETRIS_API tetris_game* tetris_game_create(uint32_t seed);
+TETRIS_API void tetris_game_destroy(tetris_game* game);
+
+TETRIS_API int tetris_game_is_over(const tetris_game* game);
+TETRIS_API int tetris_game_score(const tetris_game* game);
+/* Pieces placed so far */
+TETRIS_API int64_t tetris_game_steps(const tetris_game* game);
+/* Current piece and preview */
+TETRIS_API int tetris_game_pieces(const tetris_game* game, int32_t* current, int32_t* next);
+/* Writes the occupancy of the rows (bit x set if column x is filled, row 0 at the bottom)
+ * into rows[0..capacity). Returns the number of rows of the grid, including the hidden
+ * buffer rows, or TETRIS_ERROR if capacity is too small. With rows == NULL and
+ * capacity == 0 it only returns the row count, for sizing the buffer. */
+TETRIS_API int tetris_game_board(const tetris_game* game, uint32_t* rows, int capacity);
+
+/* Scores every placement of the current piece with the given weights, as one batch.
+ * Returns the number of placements n (<= capacity), or TETRIS_ERROR. Any output may be NULL:
+ *   actions[i]                     placement i
+ *   features[f * capacity + i]     feature f of placement i, f < num_weights
+ *                                  (a num_weights x capacity row-major array)
+ *   scores[i]                      weighted sum, -INFINITY if the placement ends the game */
+TETRIS_API int tetris_game_evaluate(const tetris_game* game, const double* weights, int num_weights,
+    tetris_action* actions, int32_t* features, double* scores, int capacity);
+
+/* Places the current piece at (x, rotation). Returns 1 if the game goes on, 0 if this move
+ * ended it, TETRIS_ERROR if the game was already over or the action does not exist. */
+TETRIS_API int tetris_game_play(tetris_game* game, int32_t x, int32_t rotation);
+/* Places the current piece at the best-scoring placement (as tetris_test does). `move`, if
+ * not NULL, receives the placement. Returns like tetris_game_play(). */
+TETRIS_API int tetris_game_step(tetris_game* game, const double* weights, int num_weights, tetris_action* move);
+
+/* Plays num_games complete games, game g with the piece sequence of seeds[g], spread over
+ * num_threads threads (<= 1: the calling thread). steps[g] / scores[g] (either may be NULL)
+ * receive the pieces placed and the final score. Returns TETRIS_OK or TETRIS_ERROR. */
+TETRIS_API int tetris_run_games(const double* weights, int num_weights, const uint32_t* seeds, int num_games,
+    int num_threads, int64_t* steps, int32_t* scores);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TETRIS_C_API_H */
@@ -0,0 +1,422 @@
+#include "distributed.h"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr std::uint32_t k_frame_magic = 0x4B575454; // "TTWK"
+constexpr std::uint32_t k_protocol_version = 3;
+constexpr size_t k_frame_header_size = 12;
+constexpr size_t k_result_header_size = 16; // Task id, average score, number of games
+constexpr size_t k_game_record_size = 24;
+constexpr std::uint32_t k_max_payload = 1u << 20;
+constexpr int k_connect_attempts = 50; // 50 x 100 ms
+constexpr int k_poll_timeout_ms = 1000;
+
+enum FrameType : std::uint32_t {
+    k_frame_hello = 1,
+    k_frame_task = 2,
+    k_frame_result = 3,
+    k_frame_shutdown = 4,
+};
+
+struct Frame {
+    std::uint32_t type = 0;
+    std::vector<char> payload;
+};
+
+enum class FrameStatus {
+    Incomplete, // Wait for more bytes
+    Ready,
+    Malformed,
+};
+
+void putU32(std::vector<char>& out, std::uint32_t v)
+{
+    for (int i = 0; i < 4; ++i) out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+}
+
+void putF64(std::vector<char>& out, double v)
+{
+    std::uint64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    for (int i = 0; i < 8; ++i) out.push_back(static_cast<char>((bits >> (8 * i)) & 0xFF));
+}
+
+std::uint32_t getU32(const char* p)
+{
+    std::uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) v |= static_cast<std::uint32_t>(static_cast<unsigned char>(p[i])) << (8 * i);
+    return v;
+}
+
+double getF64(const char* p)
+{
+    std::uint64_t bits = 0;
+    for (int i = 0; i < 8; ++i) bits |= static_cast<std::uint64_t>(static_cast<unsigned char>(p[i])) << (8 * i);
+    double v;
+    std::memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+std::vector<char> makeFrame(std::uint32_t type, const std::vector<char>& payload)
+{
+    std::vector<char> frame;
+    frame.reserve(k_frame_header_size + payload.size());
+    putU32(frame, k_frame_magic);
+    putU32(frame, type);
+    putU32(frame, static_cast<std::uint32_t>(payload.size()));
+    frame.insert(frame.end(), payload.begin(), payload.end());
+    return frame;
+}
+
+// Blocking write of a whole buffer; false if the peer is gone
+bool sendAll(int fd, const std::vector<char>& data)
+{
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Takes one complete frame off the front of `buffer`
+FrameStatus popFrame(std::vector<char>& buffer, Frame& frame)
+{
+    if (buffer.size() < k_frame_header_size) return FrameStatus::Incomplete;
+    std::uint32_t size = getU32(buffer.data() + 8);
+    if (getU32(buffer.data()) != k_frame_magic || size > k_max_payload) {
+        return FrameStatus::Malformed;
+    }
+    if (buffer.size() < k_frame_header_size + size) return FrameStatus::Incomplete;
+    frame.type = getU32(buffer.data() + 4);
+    frame.payload.assign(buffer.begin() + k_frame_header_size, buffer.begin() + k_frame_header_size + size);
+    buffer.erase(buffer.begin(), buffer.begin() + k_frame_header_size + size);
+    return FrameStatus::Ready;
+}
+
+// Appends whatever is available on `fd` to `buffer`; false on EOF or error
+bool receiveSome(int fd, std::vector<char>& buffer)
+{
+    char chunk[4096];
+    for (;;) {
+        ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        buffer.insert(buffer.end(), chunk, chunk + n);
+        return true;
+    }
+}
+
+// Blocking read of the next frame; false on EOF, throws on a malformed frame
+bool receiveFrame(int fd, std::vector<char>& buffer, Frame& frame)
+{
+    for (;;) {
+        FrameStatus status = popFrame(buffer, frame);
+        if (status == FrameStatus::Ready) return true;
+        if (status == FrameStatus::Malformed) {
+            throw std::runtime_error("Distributed: malformed frame from coordinator.");
+        }
+        if (!receiveSome(fd, buffer)) return false;
+    }
+}
+
+// Decodes a result frame into `reply`; false if its size does not match its game count
+bool parseResult(const Frame& frame, EvalReply& reply)
+{
+    const std::vector<char>& p = frame.payload;
+    if (p.size() < k_result_header_size) return false;
+    std::uint32_t count = getU32(p.data() + 12);
+    if (p.size() != k_result_header_size + k_game_record_size * static_cast<size_t>(count)) return false;
+    reply.id = getU32(p.data());
+    reply.average_score = getF64(p.data() + 4);
+    reply.games.resize(count);
+    for (std::uint32_t i = 0; i < count; ++i) {
+        const char* g = p.data() + k_result_header_size + k_game_record_size * i;
+        GameRecord& game = reply.games[i];
+        game.params_id = reply.id;
+        game.game = getU32(g);
+        game.seed = getU32(g + 4);
+        game.score = static_cast<int>(getU32(g + 8));
+        game.pieces = static_cast<int>(getU32(g + 12));
+        game.wall_ms = getF64(g + 16);
+    }
+    return true;
+}
+
+sockaddr_un socketAddress(const std::string& path)
+{
+    sockaddr_un addr {};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        throw std::runtime_error("Distributed: socket path too long: " + path);
+    }
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return addr;
+}
+
+} // namespace
+
+// --- Coordinator ---
+
+WorkerPool::WorkerPool(const std::string& socket_path)
+    : socket_path_(socket_path)
+{
+    sockaddr_un addr = socketAddress(socket_path);
+    listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+    if (listen_fd_ < 0) {
+        throw std::runtime_error(std::string("Distributed: socket() failed: ") + std::strerror(errno));
+    }
+    ::unlink(socket_path.c_str()); // Stale socket from an earlier run
+    if (::bind(listen_fd_, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(listen_fd_, 64) != 0) {
+        int err = errno;
+        ::close(listen_fd_);
+        throw std::runtime_error("Distributed: cannot listen on " + socket_path + ": " + std::strerror(err));
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    const std::vector<char> shutdown = makeFrame(k_frame_shutdown, {});
+    for (const Worker& worker : workers_) {
+        sendAll(worker.fd, shutdown);
+        ::close(worker.fd);
+    }
+    ::close(listen_fd_);
+    ::unlink(socket_path_.c_str());
+    // Workers that never connected have nothing to wait for once the socket is gone
+    for (int pid : spawned_pids_) {
+        if (pid <= 0) continue; // Already reaped
+        int status = 0;
+        while (::waitpid(pid, &status, 0) < 0 && errno == EINTR) { }
+    }
+}
+
+void WorkerPool::spawnLocalWorkers(const std::string& executable, int count, const CpuPlacement* placement)
+{
+    // Everything the child needs is built before fork(): other threads (spdlog, metrics writer) may hold
+    // the malloc lock at fork time, so the child only calls sched_setaffinity, execv and _exit.
+    char* argv[] = { const_cast<char*>(executable.c_str()), const_cast<char*>("--worker"),
+        const_cast<char*>(socket_path_.c_str()), nullptr };
+    spawned_pids_.reserve(spawned_pids_.size() + static_cast<size_t>(count));
+    for (int i = 0; i < count; ++i) {
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        if (placement) mask = placement->mask(i);
+        pid_t pid = ::fork();
+        if (pid < 0) {
+            throw std::runtime_error(std::string("Distributed: fork() failed: ") + std::strerror(errno));
+        }
+        if (pid == 0) {
+            if (placement) ::sched_setaffinity(0, sizeof(mask), &mask);
+            ::execv(argv[0], argv);
+            _exit(127); // exec failed; nothing of the parent may run in the child
+        }
+        spawned_pids_.push_back(static_cast<int>(pid));
+    }
+}
+
+void WorkerPool::acceptWorkers()
+{
+    for (;;) {
+        int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            return; // EAGAIN: no more pending connections
+        }
+        Worker worker;
+        worker.fd = fd;
+        workers_.push_back(std::move(worker));
+    }
+}
+
+void WorkerPool::dropWorker(size_t index, std::vector<size_t>& queue)
+{
+    Worker& worker = workers_[index];
+    if (worker.task >= 0) {
+        queue.push_back(static_cast<size_t>(worker.task)); // Someone else finishes it
+    }
+    ::close(worker.fd);
+    workers_.erase(workers_.begin() + static_cast<long>(index));
+}
+
+bool WorkerPool::spawnedWorkersAlive()
+{
+    if (spawned_pids_.empty()) return true; // External workers: wait for them indefinitely
+    bool alive = false;
+    for (int& pid : spawned_pids_) {
+        if (pid <= 0) continue;
+        int status = 0;
+        if (::waitpid(pid, &status, WNOHANG) == pid) {
+            pid = -pid; // Reaped; keep the slot so the destructor skips it
+        } else {
+            alive = true;
+        }
+    }
+    return alive;
+}
+
+void WorkerPool::evaluate(const std::vector<EvalTask>& tasks, const std::function<void(const EvalReply&)>& on_reply)
+{
+    std::vector<size_t> queue;
+    queue.reserve(tasks.size());
+    for (size_t i = tasks.size(); i-- > 0;) queue.push_back(i); // Popped from the back, so in order
+    std::vector<unsigned char> done(tasks.size(), 0);
+    size_t remaining = tasks.size();
+
+    while (remaining > 0) {
+        acceptWorkers();
+
+        // Hand queued tasks to idle workers that have said hello
+        for (size_t w = 0; w < workers_.size() && !queue.empty();) {
+            if (workers_[w].task >= 0 || !workers_[w].greeted) {
+                ++w;
+                continue;
+            }
+            size_t index = queue.back();
+            queue.pop_back();
+            if (done[index]) continue; // Finished by a worker that was presumed dead
+            const EvalTask& task = tasks[index];
+            std::vector<char> payload;
+            putU32(payload, task.id);
+            putU32(payload, task.seed);
+            putU32(payload, static_cast<std::uint32_t>(task.params.size()));
+            for (double p : task.params) putF64(payload, p);
+            workers_[w].task = static_cast<long>(index);
+            if (!sendAll(workers_[w].fd, makeFrame(k_frame_task, payload))) {
+                dropWorker(w, queue);
+                continue;
+            }
+            ++w;
+        }
+
+        if (workers_.empty() && !spawnedWorkersAlive()) {
+            throw std::runtime_error("Distributed: all workers exited with " + std::to_string(remaining) + " tasks left.");
+        }
+
+        std::vector<pollfd> fds;
+        fds.push_back({ listen_fd_, POLLIN, 0 });
+        for (const Worker& worker : workers_) fds.push_back({ worker.fd, POLLIN, 0 });
+        int ready = ::poll(fds.data(), fds.size(), k_poll_timeout_ms);
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            throw std::runtime_error(std::string("Distributed: poll() failed: ") + std::strerror(errno));
+        }
+
+        // Walk backwards so dropping a worker does not shift the ones still to visit
+        for (size_t w = workers_.size(); w-- > 0;) {
+            if (!(fds[w + 1].revents & (POLLIN | POLLHUP | POLLERR))) continue;
+            Worker& worker = workers_[w];
+            if (!receiveSome(worker.fd, worker.inbox)) {
+                dropWorker(w, queue);
+                continue;
+            }
+            // A worker that breaks the protocol is dropped like one that disconnected
+            bool healthy = true;
+            Frame frame;
+            EvalReply reply;
+            while (healthy) {
+                FrameStatus status = popFrame(worker.inbox, frame);
+                if (status == FrameStatus::Incomplete) break;
+                if (status == FrameStatus::Malformed) {
+                    healthy = false;
+                } else if (!worker.greeted) {
+                    // The first frame must be a hello of this protocol version
+                    healthy = frame.type == k_frame_hello && frame.payload.size() == 8
+                        && getU32(frame.payload.data()) == k_protocol_version;
+                    worker.greeted = healthy;
+                } else if (frame.type == k_frame_result && worker.task >= 0 && parseResult(frame, reply)
+                    && reply.id == tasks[static_cast<size_t>(worker.task)].id) {
+                    size_t index = static_cast<size_t>(worker.task);
+                    worker.task = -1;
+                    if (done[index]) continue;
+                    done[index] = 1;
+                    remaining--;
+                    on_reply(reply);
+                } else {
+                    healthy = false; // Unexpected frame, or a result for a task it does not hold
+                }
+            }
+            if (!healthy) {
+                dropWorker(w, queue);
+            }
+        }
+    }
+}
+
+// --- Worker ---
+
+int runWorker(const std::string& socket_path, const std::function<EvalReply(const EvalTask&)>& evaluate)
+{
+    sockaddr_un addr = socketAddress(socket_path);
+    int fd = -1;
+    for (int attempt = 0; attempt < k_connect_attempts && fd < 0; ++attempt) {
+        fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) return 1;
+        if (::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+            ::close(fd);
+            fd = -1;
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    }
+    if (fd < 0) return 1;
+
+    std::vector<char> hello;
+    putU32(hello, k_protocol_version);
+    putU32(hello, static_cast<std::uint32_t>(::getpid()));
+    if (!sendAll(fd, makeFrame(k_frame_hello, hello))) {
+        ::close(fd);
+        return 1;
+    }
+
+    std::vector<char> buffer;
+    Frame frame;
+    int status = 1;
+    while (receiveFrame(fd, buffer, frame)) {
+        if (frame.type == k_frame_shutdown) {
+            status = 0;
+            break;
+        }
+        if (frame.type != k_frame_task || frame.payload.size() < 12) {
+            throw std::runtime_error("Distributed: unexpected frame from coordinator.");
+        }
+        EvalTask task;
+        task.id = getU32(frame.payload.data());
+        task.seed = getU32(frame.payload.data() + 4);
+        std::uint32_t count = getU32(frame.payload.data() + 8);
+        if (frame.payload.size() != 12 + 8 * static_cast<size_t>(count)) {
+            throw std::runtime_error("Distributed: malformed task.");
+        }
+        task.params.resize(count);
+        for (std::uint32_t i = 0; i < count; ++i) task.params[i] = getF64(frame.payload.data() + 12 + 8 * i);
+
+        const EvalReply reply = evaluate(task);
+        std::vector<char> result;
+        result.reserve(k_result_header_size + k_game_record_size * reply.games.size());
+        putU32(result, task.id);
+        putF64(result, reply.average_score);
+        putU32(result, static_cast<std::uint32_t>(reply.games.size()));
+        for (const GameRecord& game : reply.games) {
+            putU32(result, game.game);
+            putU32(result, game.seed);
+            putU32(result, static_cast<std::uint32_t>(game.score));
+            putU32(result, static_cast<std::uint32_t>(game.pieces));
+            putF64(result, game.wall_ms);
+        }
+        if (!sendAll(fd, makeFrame(k_frame_result, result))) break;
+    }
+    ::close(fd);
+    return status;
+}
@@ -0,0 +1,85 @@
+#ifndef DISTRIBUTED_H
+#define DISTRIBUTED_H
+
+#include "affinity.h"
+#include "metrics.h" // GameRecord
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// --- Coordinator / worker evaluation over a Unix stream socket (POSIX only) ---
+// The coordinator (runTraining) listens on a socket path; worker processes
+// (`tetris_train --worker <path>`) connect, receive candidate parameter vectors and send
+// back their average scores. Each message is a frame
+//     u32 magic 'TTWK', u32 type, u32 payload_size, payload
+// with little-endian integers and IEEE doubles:
+//     hello    worker -> coordinator  u32 protocol version, u32 pid
+//     task     coordinator -> worker  u32 task id, u32 run seed, u32 num_params, f64 params[]
+//     result   worker -> coordinator  u32 task id, f64 average score, u32 num_games,
+//                                     games[] { u32 game, u32 seed, i32 score, i32 pieces, f64 wall_ms }
+//     shutdown coordinator -> worker  (empty)
+// A worker must open with a hello of the coordinator's protocol version. One that does not,
+// sends a malformed or unexpected frame, or answers a task it does not hold is disconnected
+// and its task re-queued. Nothing in the protocol depends on the transport being local.
+
+struct EvalTask {
+    std::uint32_t id = 0;
+    std::uint32_t seed = 0; // Run seed the worker derives its game seeds from
+    std::vector<double> params;
+};
+
+struct EvalReply {
+    std::uint32_t id = 0;
+    double average_score = 0.0;
+    std::vector<GameRecord> games; // Metrics of the evaluation's games; params_id is `id`
+};
+
+class WorkerPool {
+public:
+    // Listens on `socket_path`, replacing a stale socket file.
+    // Throws std::runtime_error if the socket cannot be created.
+    explicit WorkerPool(const std::string& socket_path);
+    // Tells connected workers to exit, waits for spawned ones and removes the socket file.
+    ~WorkerPool();
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    // Stand-in launcher for one machine: fork/exec `count` copies of
+    // `executable --worker <socket_path>`. With a placement, worker k starts with the
+    // affinity of slot k (set in the child before exec, so it allocates on its node).
+    void spawnLocalWorkers(const std::string& executable, int count, const CpuPlacement* placement = nullptr);
+
+    // Hands every task to an idle worker and calls `on_reply` (on this thread) as results
+    // arrive; a reply carries the id of the task it answers as recorded here, never one
+    // read off the wire. Tasks of a worker that disconnects or is dropped are re-queued. Workers may connect at any
+    // time; throws std::runtime_error if none is connected and every spawned one has exited.
+    void evaluate(const std::vector<EvalTask>& tasks, const std::function<void(const EvalReply&)>& on_reply);
+
+    int connectedWorkers() const { return static_cast<int>(workers_.size()); }
+
+private:
+    struct Worker {
+        int fd = -1;
+        long task = -1; // Index into the current task list, -1 when idle
+        bool greeted = false; // Sent a hello of our protocol version
+        std::vector<char> inbox;
+    };
+
+    void acceptWorkers();
+    void dropWorker(size_t index, std::vector<size_t>& queue);
+    bool spawnedWorkersAlive();
+
+    std::string socket_path_;
+    int listen_fd_ = -1;
+    std::vector<Worker> workers_;
+    std::vector<int> spawned_pids_;
+};
+
+// Worker side: connects to the coordinator at `socket_path` (retrying for a few seconds)
+// and answers tasks with `evaluate(task)` until told to shut down. The reply's id is taken
+// from the task.
+// Returns 0 on orderly shutdown, 1 if the coordinator could not be reached or went away.
+int runWorker(const std::string& socket_path, const std::function<EvalReply(const EvalTask&)>& evaluate);
+
+#endif // DISTRIBUTED_H
@@ -1,11 +1,13 @@
 #include "extractor.h"
 #include "constants.h" // Required for getOriginalBlock
+#include "instrumentation.h"
 #include "models.h"
 #include <algorithm> // For std::max_element, std::all_of, std::copy, std::fill
 #include <cmath> // For std::abs
+#include <cstdint>
 #include <numeric> // For std::accumulate
-#include <set>
 #include <stdexcept>
+#include <utility> // For std::swap
 #include <vector>
 
 // --- Helper function declarations (from game.py, needed here) ---
@@ -27,328 +29,261 @@ int MyDbtFeatureExtractorCpp::calculateLandingHeight(int y_offset) const
     return y_offset + 1;
 }
 
-// Make static as it doesn't depend on instance state
-/* static */ bool MyDbtFeatureExtractorCpp::isFullLine(const std::vector<const Block*>& line, int width) const /* const removed */
-{
-    // Check only the logical width of the board
-    if (line.size() < width)
-    return std::all_of(line.begin(), line.begin() + width, [](const Block* b) { return b != nullptr; });
-}
-
-// Make static as it doesn't depend on instance state and calls static isFullLine
+// Uses the board's row masks, no cell scan
 /* static */ std::vector<int> MyDbtFeatureExtractorCpp::getFullLines(const Board& board) const /* const removed */
 {
     std::vector<int> full_lines;
     int height = board.size.height; // Logical height
-    full_lines.reserve(height); // Reserve space
     // Iterate only up to the logical height of the board
     for (int y = 0; y < height; ++y) {
-        // Call the static version
-        if (MyDbtFeatureExtractorCpp::isFullLine(board.squares[y], board.size.width)) {
+        if (board.isRowFull(y)) {
             full_lines.push_back(y);
         }
     }
     return full_lines;
 }
 
-int MyDbtFeatureExtractorCpp::calculateErodedPieceCells(const Board& board_before_elim, const BlockStatus& action, int y_offset, const std::vector<int>& full_lines) const
+/* static */ MyDbtFeatureExtractorCpp::FeaturePlan MyDbtFeatureExtractorCpp::makePlan(int num_features, FeatureMask mask)
 {
-    if (full_lines.empty()) {
-        return 0;
-    }
-    if (!action.rotation) return 0; // Safety check
-
-    // int block_height = action.rotation->size.height; // block_height not used
-    int eliminate_bricks = 0;
-
-    for (const auto& pos : action.rotation->occupied) { // Use ->
-        int occupied_y = pos.y + y_offset;
-        // Check if this cell's y-coordinate is one of the full lines
-        for (int line_y : full_lines) {
-            if (occupied_y == line_y) {
-                eliminate_bricks++;
-                break; // Count each occupied cell at most once per full line it's in
-            }
+    FeaturePlan plan;
+    for (int feature = 1; feature < num_features; ++feature) {
+        if (!featureEnabled(mask, feature)) {
+            continue;
+        }
+        plan.overlay = true;
+        switch (feature) {
+        case 2: plan.row_transitions = true; break;
+        case 3: plan.column_transitions = true; break;
+        case 4: case 6: case 7: plan.holes = true; break;
+        case 5: plan.wells = true; break;
+        default:
+            if (feature >= k_num_core_features) plan.column_heights = true;
+            break;
         }
     }
-
-    return full_lines.size() * eliminate_bricks;
+    return plan;
 }
 
-int MyDbtFeatureExtractorCpp::calculateRowTransitions(const Board& board_after_elim) const
+// Transitions, holes and wells are computed on row masks by the kernels in bitboard.cpp,
+// specialised at compile time for the 10x14 / 10x16 boards and picked per CPU at runtime.
+// Walls are not counted as transitions.
+// The fused kernel shares one pass over the rows between all groups, so the separate
+// kernels are only used when the plan needs a single group.
+void MyDbtFeatureExtractorCpp::calculateBoardFeatures(const BitRows& bits_after_elim, const FeaturePlan& plan, Features& f) const
 {
-    int transitions = 0;
-    const auto& squares = board_after_elim.squares;
-    int height = board_after_elim.size.height; // Logical height
-    int width = board_after_elim.size.width; // Logical width
+    int groups = plan.row_transitions + plan.column_transitions + plan.holes + plan.wells;
+    if (groups > 1) {
+        BoardFeatures board_features;
+        computeBoardFeatures(bits_after_elim, board_features);
+        f.row_transitions = board_features.row_transitions;
+        f.column_transitions = board_features.column_transitions;
+        f.holes = board_features.holes;
+        f.hole_depth = board_features.hole_depth;
+        f.rows_with_holes = board_features.rows_with_holes;
+        f.board_wells = board_features.board_wells;
+        return;
+    }
+    if (plan.row_transitions) f.row_transitions = countRowTransitions(bits_after_elim);
+    if (plan.column_transitions) f.column_transitions = countColumnTransitions(bits_after_elim);
+    if (plan.holes) countHoles(bits_after_elim, f.holes, f.hole_depth, f.rows_with_holes);
+    if (plan.wells) f.board_wells = countWells(bits_after_elim);
+}
 
-    for (int y = 0; y < height; ++y) {
-        // --- REMOVED WALL CHECK ---
-        // // Add transitions for left wall (empty to block)
-        // if (squares[y][0] != nullptr) {
-        //     transitions++;
-        // }
-        // --- END REMOVED WALL CHECK ---
-
-        // Check transitions between adjacent cells within the row
-        for (int x = 0; x < width - 1; ++x) {
-            bool current_filled = (squares[y][x] != nullptr);
-            bool next_filled = (squares[y][x + 1] != nullptr);
-            if (current_filled != next_filled) {
-                transitions++;
-            }
+// Matches the Python calculation: height = logical_height - y of the topmost block in rows
+// [0, height), 0 for an empty column.
+void MyDbtFeatureExtractorCpp::calculateColumnHeights(const BitRows& bits_after_elim, Features& f) const
+{
+    f.column_heights.fill(0);
+    const RowMask full = fullRowMask(bits_after_elim.width);
+    RowMask found = 0;
+    for (int y = bits_after_elim.height - 1; y >= 0 && found != full; --y) {
+        RowMask fresh = bits_after_elim.rows[y] & ~found & full;
+        while (fresh) {
+            f.column_heights[lowestBit32(fresh)] = bits_after_elim.height - y;
+            fresh &= fresh - 1;
         }
-        // --- REMOVED WALL CHECK ---
-        // // Add transitions for right wall (block to empty)
-        // if (squares[y][width - 1] != nullptr) {
-        //     transitions++;
-        // }
-        // --- END REMOVED WALL CHECK ---
+        found |= bits_after_elim.rows[y];
     }
-    return transitions;
 }
 
-// ... existing includes ...
-
-int MyDbtFeatureExtractorCpp::calculateColumnTransitions(const Board& board_after_elim) const
+int MyDbtFeatureExtractorCpp::calculateMaximumHeight(const Features& f) const
 {
-    int transitions = 0;
-    const auto& squares = board_after_elim.squares;
-    int height = board_after_elim.size.height; // Logical height
-    int width = board_after_elim.size.width; // Logical width
-
-    for (int x = 0; x < width; ++x) {
-        // --- REMOVED WALL CHECK ---
-        // // Add transitions for bottom wall (empty to block) - assuming y=0 is bottom
-        // if (squares[0][x] != nullptr) {
-        //      transitions++;
-        // }
-        // --- END REMOVED WALL CHECK ---
-
-        // Check transitions between adjacent cells within the column
-        for (int y = 0; y < height - 1; ++y) {
-            bool current_filled = (squares[y][x] != nullptr);
-            bool next_filled = (squares[y + 1][x] != nullptr);
-            if (current_filled != next_filled) {
-                transitions++;
-            }
-        }
-        // --- REMOVED WALL CHECK ---
-        // // Add transitions for top boundary (block to empty) - Check highest logical row
-        //  if (height > 0 && squares[height - 1][x] != nullptr) {
-        //      // Check if cell *above* logical height is empty (implicitly true)
-        //      transitions++;
-        //  }
-        // --- END REMOVED WALL CHECK ---
+    if (f.width == 0) {
+        return 0;
     }
-    return transitions;
+    return *std::max_element(f.column_heights.begin(), f.column_heights.begin() + f.width);
 }
 
-// ... rest of the file ...
+void MyDbtFeatureExtractorCpp::loadBase(const Board& board, BaseBoard& base) const
+{
+    loadBitRows(board, base.bits);
+    columnTops(base.bits, base.column_tops);
+}
 
-void MyDbtFeatureExtractorCpp::calculateHolesAndDepth(const Board& board_after_elim, int& holes_count, int& total_hole_depth, int& rows_with_holes_count) const
+void MyDbtFeatureExtractorCpp::loadBase(const BitRows& bits, BaseBoard& base) const
 {
-    holes_count = 0;
-    total_hole_depth = 0;
-    std::set<int> rows_with_holes_set;
-    const auto& squares = board_after_elim.squares;
-    int height = board_after_elim.size.height; // Logical height
-    int width = board_after_elim.size.width; // Logical width
-    int grid_height = board_after_elim.getGridHeight(); // Actual grid height including buffer
-
-    for (int x = 0; x < width; ++x) {
-        bool block_encountered = false;
-        int current_depth_contribution = 0; // Blocks above current cell in this column scan
-
-        // Iterate top-down through the *entire* grid height, including buffer
-        for (int y = grid_height - 2; y >= 0; --y) {
-            // Only consider cells within the logical board height for hole *detection*
-            // but consider blocks *above* the logical height for depth calculation.
-            if (squares[y][x] != nullptr) {
-                block_encountered = true;
-                current_depth_contribution++;
-            } else if (block_encountered && y < height) { // It's a hole only if below a block AND within logical height
-                holes_count++;
-                rows_with_holes_set.insert(y);
-                // Depth is blocks strictly above the hole
-                total_hole_depth += (current_depth_contribution);
-            }
-        }
-    }
-    rows_with_holes_count = rows_with_holes_set.size();
+    base.bits = bits;
+    columnTops(base.bits, base.column_tops);
 }
 
-int MyDbtFeatureExtractorCpp::calculateBoardWells(const Board& board_after_elim) const
+// Same result as findYOffset: the lowest row where every piece cell sits above the topmost
+// block of its column, or -1 if the piece leaves the board sideways or overflows the
+// logical height there.
+int MyDbtFeatureExtractorCpp::landingRow(const BaseBoard& base, const BlockStatus& action, PiecePlacement& piece) const
 {
-    int wells_sum = 0;
-    const auto& squares = board_after_elim.squares;
-    int height = board_after_elim.size.height; // Logical height
-    int width = board_after_elim.size.width; // Logical width
-
-    for (int x = 0; x < width; ++x) {
-        int current_well_depth = 0;
-        for (int y = height - 1; y >= 0; --y) { // Iterate top-down within logical height
-            if (squares[y][x] == nullptr) {
-                bool left_filled = (x == 0) || (squares[y][x - 1] != nullptr);
-                bool right_filled = (x == width - 1) || (squares[y][x + 1] != nullptr);
-                if (left_filled && right_filled) {
-                    current_well_depth++;
-                } else {
-                    if (current_well_depth > 0) {
-                        wells_sum += (current_well_depth * (current_well_depth + 1)) / 2;
-                    }
-                    current_well_depth = 0;
-                }
-            } else {
-                if (current_well_depth > 0) {
-                    wells_sum += (current_well_depth * (current_well_depth + 1)) / 2;
-                }
-                current_well_depth = 0;
-            }
+    piece = PiecePlacement();
+    int y_offset = 0;
+    int top_cell = 0;
+    for (const auto& pos : action.rotation->occupied) {
+        int x = action.x_offset + pos.x;
+        if (x < 0 || x >= base.bits.width) {
+            return -1;
         }
-        // Add wells extending to the bottom
-        if (current_well_depth > 0) {
-            wells_sum += (current_well_depth * (current_well_depth + 1)) / 2;
+        if (pos.y < 0 || pos.y >= k_max_piece_rows) {
+            throw std::logic_error("Block rotation taller than k_max_piece_rows.");
         }
+        piece.rows[pos.y] |= RowMask(1) << x;
+        y_offset = std::max(y_offset, base.column_tops[x] - pos.y);
+        top_cell = std::max(top_cell, pos.y);
     }
-    return wells_sum;
+    if (y_offset + top_cell >= base.bits.height) {
+        return -1;
+    }
+    piece.y = y_offset;
+    piece.height = top_cell + 1;
+    return y_offset;
 }
 
-// ... existing includes ...
-
-std::vector<int> MyDbtFeatureExtractorCpp::calculateColumnHeights(const Board& board_after_elim) const
+bool MyDbtFeatureExtractorCpp::computeFeatures(const BaseBoard& base, PlacementOverlay& overlay, const BlockStatus& action, const FeaturePlan& plan, Features& f,
+    int* landing_row, BitRows* placed) const
 {
-    int width = board_after_elim.size.width;
-    int height = board_after_elim.size.height; // Logical height
-    std::vector<int> heights(width, 0);
-    const auto& squares = board_after_elim.squares;
-
-    for (int x = 0; x < width; ++x) {
-        // Iterate top-down within logical height (from y=height-1 down to 0)
-        for (int y = height - 1; y >= 0; --y) {
-            if (squares[y][x] != nullptr) {
-                // Python calculates height as distance from top + 1? No, it's board.size.height - row
-                // If top block is at y=13 (height=14), python height = 14-13 = 1.
-                // If top block is at y=0 (height=14), python height = 14-0 = 14.
-                // Let's match the Python logic: height = logical_height - y_index
-                // Wait, Python iterates 0 to height. If block at row 0, height = 14-0=14. If block at row 13, height=14-13=1.
-                // C++ iterates height-1 down to 0. If block at y=13, height = 13+1 = 14. If block at y=0, height = 0+1 = 1.
-                // The Python logic seems reversed or calculates empty space above.
-                // Let's stick to the C++ logic (y+1) as it represents the actual height from the bottom (row 0).
-                // The previous analysis of Python was incorrect. Python iterates top-down (0 to height-1).
-                // If block found at row `r`, height = `board.size.height - r`.
-                // Example: height=14. Block at row 0 -> 14-0=14. Block at row 13 -> 14-13=1.
-                // Let's implement the Python logic correctly.
-                heights[x] = height - y; // Match Python's calculation
-                break; // Found highest block in column
-            }
-        }
-        // If loop finishes, height remains 0 (correct for empty column)
+    // --- 1. Find Placement Offset ---
+    PiecePlacement piece;
+    int y_offset = landingRow(base, action, piece);
+    if (y_offset == -1) {
+        return false;
+    }
+    f.landing_height = calculateLandingHeight(y_offset);
+    if (landing_row) {
+        *landing_row = y_offset;
+    }
+    if (!plan.overlay && !placed) {
+        return true;
     }
-    return heights;
-}
 
-// ... rest of the file ...
+    // --- 2. Overlay the piece on the base rows (no Board copy) ---
+    // Only the rows the piece occupies can have become full
+    overlay.place(piece);
 
-std::vector<int> MyDbtFeatureExtractorCpp::calculateColumnDifferences(const std::vector<int>& column_heights) const
-{
-    if (column_heights.size() < 2) {
-        return {};
+    // --- 3. Pre-Elimination Features ---
+    f.eroded_piece_cells = overlay.erodedPieceCells();
+
+    // --- 4. Post-Elimination Features, read through the overlay ---
+    const BitRows& bits = overlay.rows();
+    calculateBoardFeatures(bits, plan, f);
+    if (plan.column_heights) {
+        f.width = bits.width;
+        calculateColumnHeights(bits, f);
+        f.maximum_height = calculateMaximumHeight(f);
     }
-    std::vector<int> differences;
-    differences.reserve(column_heights.size() - 1); // Reserve exact space
-    for (size_t i = 0; i < column_heights.size() - 1; ++i) {
-        differences.push_back(std::abs(column_heights[i] - column_heights[i + 1]));
+    if (placed) {
+        *placed = bits;
     }
-    return differences;
+    overlay.lift();
+    return true;
 }
 
-int MyDbtFeatureExtractorCpp::calculateMaximumHeight(const std::vector<int>& column_heights) const
+/* static */ int MyDbtFeatureExtractorCpp::featureValue(const Features& f, int index)
 {
-    if (column_heights.empty()) {
-        return 0;
+    switch (index) {
+    case 0: return f.landing_height;
+    case 1: return f.eroded_piece_cells;
+    case 2: return f.row_transitions;
+    case 3: return f.column_transitions;
+    case 4: return f.holes;
+    case 5: return f.board_wells;
+    case 6: return f.hole_depth;
+    case 7: return f.rows_with_holes;
+    default: break;
     }
-    return *std::max_element(column_heights.begin(), column_heights.end());
-}
-
-void ensureNoNullLine(Board& board) {
-    auto& squares = board.squares;
-    for (auto& line : squares) {
-        if (line.empty()) {
-            line = std::vector<const Block*>(squares[0].size(), nullptr);
-        }
+    int extended = index - k_num_core_features;
+    if (extended < f.width) {
+        return f.column_heights[extended];
+    }
+    extended -= f.width;
+    if (extended < f.width - 1) {
+        return std::abs(f.column_heights[extended] - f.column_heights[extended + 1]);
     }
+    if (extended == f.width - 1) {
+        return f.maximum_height;
+    }
+    return 0; // Past the last feature
 }
 
 std::vector<int> MyDbtFeatureExtractorCpp::extractFeatures(const Game& game, const BlockStatus& action) const
 {
+    TETRIS_PROBE(k_probe_extract_features);
     if (!action.rotation) {
          throw std::runtime_error("Invalid action: rotation pointer is null.");
     }
-    // --- 1. Find Placement Offset ---
-    int y_offset = findYOffset(game.board, action);
-    if (y_offset == -1) {
+    BaseBoard base;
+    loadBase(game.board, base);
+    PlacementOverlay overlay(base.bits);
+    const int num_features = numFeatures(base.bits.width);
+    Features f;
+    if (!computeFeatures(base, overlay, action, makePlan(num_features, k_all_features), f)) {
         throw std::runtime_error("Invalid action: Cannot place block or causes game over.");
     }
 
-    // --- 2. Simulate Placement & Elimination on ONE Copy ---
-    Board board_copy = game.board; // Use Board's copy constructor ONCE
-
-    // Get the original block pointer - needed for placing on board
-    const Block* block_to_place = getBlockFromRotation(action.rotation);
-    if (!block_to_place) {
-        throw std::runtime_error("Could not determine block type during feature extraction.");
-    }
-
-    // Place the piece on the copy
-    for (const auto& pos : action.rotation->occupied) { // Use ->
-        int place_x = action.x_offset + pos.x;
-        int place_y = y_offset + pos.y;
-        if (place_y >= 0 && place_y < board_copy.getGridHeight() && place_x >= 0 && place_x < board_copy.size.width) {
-            board_copy.squares[place_y][place_x] = block_to_place; // Place pointer to original block
-        } else {
-            throw std::logic_error("Placement out of bounds during feature extraction simulation.");
-        }
-    }
-
-    // --- 3. Calculate Pre-Elimination Features ---
-    Features f;
-    // Need full lines *before* elimination for eroded_piece_cells
-    std::vector<int> full_lines = MyDbtFeatureExtractorCpp::getFullLines(board_copy); // Assuming static is okay
-
-    f.landing_height = calculateLandingHeight(y_offset);
-    f.eroded_piece_cells = calculateErodedPieceCells(board_copy, action, y_offset, full_lines); // Use the copied board
-
-    // --- 4. Eliminate Lines on the Copy ---
-    int eliminated_count = eliminateLines(board_copy); // Modifies board_copy
-
-    // --- 5. Calculate Post-Elimination Features ---
-    // Use the modified board_copy for these features
-    f.row_transitions = calculateRowTransitions(board_copy);
-    f.column_transitions = calculateColumnTransitions(board_copy);
-    calculateHolesAndDepth(board_copy, f.holes, f.hole_depth, f.rows_with_holes);
-    f.board_wells = calculateBoardWells(board_copy);
-    f.column_heights = calculateColumnHeights(board_copy);
-    f.column_differences = calculateColumnDifferences(f.column_heights);
-    f.maximum_height = calculateMaximumHeight(f.column_heights);
-
-    // --- 6. Assemble Feature Vector ---
+    // --- 6. Assemble Feature Vector (same order as the Python extractor) ---
     std::vector<int> feature_vector;
-    feature_vector.reserve(8); // Reserve space for the 8 core features
+    feature_vector.reserve(num_features);
+    for (int i = 0; i < num_features; ++i) {
+        feature_vector.push_back(featureValue(f, i));
+    }
+    return feature_vector;
+}
 
-    feature_vector.push_back(f.landing_height);
-    feature_vector.push_back(f.eroded_piece_cells);
-    feature_vector.push_back(f.row_transitions);
-    feature_vector.push_back(f.column_transitions);
-    feature_vector.push_back(f.holes);
-    feature_vector.push_back(f.board_wells);
-    feature_vector.push_back(f.hole_depth);
-    feature_vector.push_back(f.rows_with_holes);
+void MyDbtFeatureExtractorCpp::extractFeaturesBatch(const Game& game, const std::vector<BlockStatus>& actions, int num_features, FeatureMask mask, FeatureBatch& out, PlacementBatch* placements) const
+{
+    BaseBoard base;
+    loadBase(game.board, base);
+    extractBatch(base, actions, num_features, mask, out, placements);
+}
 
-    // Optional: Add extended features if needed by the model length
-    // ...
+void MyDbtFeatureExtractorCpp::extractFeaturesBatch(const GameState& state, const std::vector<BlockStatus>& actions, int num_features, FeatureMask mask, FeatureBatch& out, PlacementBatch* placements) const
+{
+    BaseBoard base;
+    loadBase(state.board, base);
+    extractBatch(base, actions, num_features, mask, out, placements);
+}
 
-    return feature_vector;
+void MyDbtFeatureExtractorCpp::extractBatch(BaseBoard& base, const std::vector<BlockStatus>& actions, int num_features, FeatureMask mask, FeatureBatch& out, PlacementBatch* placements) const
+{
+    out.resize(num_features, static_cast<int>(actions.size()));
+    if (placements) {
+        placements->resize(out.count);
+    }
+    const int n = std::min(num_features, numFeatures(base.bits.width));
+    const FeaturePlan plan = makePlan(n, mask);
+    // Every candidate is laid over the same base rows
+    PlacementOverlay overlay(base.bits);
+    Features f;
+    for (int i = 0; i < out.count; ++i) {
+        TETRIS_PROBE(k_probe_extract_features);
+        const BlockStatus& action = actions[i];
+        int* landing_row = placements ? &placements->landing_rows[i] : nullptr;
+        BitRows* placed = placements ? &placements->boards[i] : nullptr;
+        if (!action.rotation || !computeFeatures(base, overlay, action, plan, f, landing_row, placed)) {
+            continue; // valid[i] stays 0
+        }
+        for (int feature = 0; feature < n; ++feature) {
+            if (featureEnabled(mask, feature)) {
+                out.column(feature)[i] = featureValue(f, feature);
+            }
+        }
+        out.valid[i] = 1;
+    }
 }
 
 
@@ -377,65 +312,57 @@ const Block* getBlockFromRotation(const BlockRotation* rotation) {
 
 // --- Definition for eliminateLines (if not defined in game.cpp) ---
 // This function modifies the board state.
-int eliminateLines(Board& board)
+// Fullness is read from the per-row masks; compaction is a single pass that swaps
+// surviving rows down (no row reallocation) and clears the rows left on top.
+int eliminateLines(Board& board, int y_begin, int y_end)
 {
-    std::vector<int> full_lines;
-    int width = board.size.width;
-    int height = board.size.height; // Logical height
-    full_lines.reserve(height); // Reserve space
-
-    // Find full lines within logical height
-    for (int y = 0; y < height; ++y) {
-        bool line_full = true;
-        for (int x = 0; x < width; ++x) {
-            if (board.squares[y][x] == nullptr) {
-                line_full = false;
-                break;
-            }
-        }
-        if (line_full) {
-            full_lines.push_back(y);
+    TETRIS_PROBE(k_probe_eliminate_lines);
+    y_begin = std::max(y_begin, 0);
+    y_end = std::min(y_end, board.size.height); // Only logical rows can be cleared
+
+    std::uint64_t full_rows = 0; // Bit y set if row y is full (grid height <= 64, see Board)
+    int num_full_lines = 0;
+    int lowest_full = -1;
+    for (int y = y_begin; y < y_end; ++y) {
+        if (board.isRowFull(y)) {
+            full_rows |= std::uint64_t(1) << y;
+            num_full_lines++;
+            if (lowest_full == -1) lowest_full = y;
         }
     }
-
-    auto num_full_lines = full_lines.size();
     if (num_full_lines == 0) {
         return 0;
     }
-
-    // Use two pointers (read/write) - modify in place
-    int write_y = 0;
-    // Iterate through all rows in the grid (including buffer potentially)
-    for (int read_y = 0; read_y < board.getGridHeight(); ++read_y) {
-        bool is_full = false;
-        // Check if read_y is one of the full lines we identified
-        for (int full_y : full_lines) {
-            if (read_y == full_y) {
-                is_full = true;
-                break;
-            }
+    TETRIS_COUNT(k_counter_lines_cleared, num_full_lines);
+
+    // Rows below the lowest full line stay where they are
+    int grid_height = board.getGridHeight();
+    int write_y = lowest_full;
+    for (int read_y = lowest_full; read_y < grid_height; ++read_y) {
+        if ((full_rows >> read_y) & 1) {
+            continue; // Skip full lines (don't increment write_y)
         }
-
-        if (!is_full) {
-            if (write_y != read_y) {
-                // Move row down
-                board.squares[write_y] = std::move(board.squares[read_y]);
-            }
-            write_y++;
+        if (write_y != read_y) {
+            std::swap(board.squares[write_y], board.squares[read_y]); // Move row down
+            board.row_masks[write_y] = board.row_masks[read_y];
         }
-        // If it is a full line, we just skip it (don't increment write_y)
+        write_y++;
     }
 
     // Clear the lines at the top (up to grid height)
-    for (int y = write_y; y < board.getGridHeight(); ++y) {
+    for (int y = write_y; y < grid_height; ++y) {
         std::fill(board.squares[y].begin(), board.squares[y].end(), nullptr);
+        board.row_masks[y] = 0;
     }
 
-    ensureNoNullLine(board); // Ensure no null lines remain
-
     return num_full_lines;
 }
 
+int eliminateLines(Board& board)
+{
+    return eliminateLines(board, 0, board.size.height);
+}
+
 // --- Definitions for helper functions (isCollision, isOverflow, findYOffset) ---
 // These are needed by the extractor and potentially game logic.
 // Place them here or in game.cpp. Let's put them here for now.
@@ -496,6 +423,7 @@ bool isOverflow(const Board& board, const BlockStatus& action, int y_offset)
 // Corrected findYOffset implementation (using optimized isCollision and isOverflow)
 int findYOffset(const Board& board, const BlockStatus& action)
 {
+    TETRIS_PROBE(k_probe_find_y_offset);
     if (!action.rotation) return -1; // Cannot place null rotation
 
     // Start checking from y_offset = 0 upwards.
@@ -1,9 +1,11 @@
 #ifndef EXTRACTOR_H
 #define EXTRACTOR_H
 
+#include "bitboard.h"
+#include "game_state.h"
 #include "models.h"
+#include <array>
 #include <vector>
-#include <set> // For std::set
 
 // Forward declaration
 class Board;
@@ -26,31 +28,64 @@ private:
         int board_wells = 0;
         int hole_depth = 0;
         int rows_with_holes = 0;
-        std::vector<int> column_heights;
-        std::vector<int> column_differences;
+        int width = 0; // Board width, sizes the extended features
+        std::array<int, k_max_board_width> column_heights {};
         int maximum_height = 0;
     };
 
+    // Which parts of computeFeatures() a FeatureMask needs, resolved once per batch
+    struct FeaturePlan {
+        bool overlay = false; // Anything past landing height: the piece must be placed
+        bool row_transitions = false;
+        bool column_transitions = false;
+        bool holes = false; // holes, hole_depth, rows_with_holes
+        bool wells = false;
+        bool column_heights = false; // Any extended feature
+    };
+    static FeaturePlan makePlan(int num_features, FeatureMask mask);
+
     // Helper functions corresponding to Python _get_* methods
     // They now take the relevant board state(s) as const references
     // and return the calculated value directly.
     int calculateLandingHeight(int y_offset) const;
-    int calculateErodedPieceCells(const Board& board_before_elim, const BlockStatus& action, int y_offset, const std::vector<int>& full_lines) const;
-    int calculateRowTransitions(const Board& board_after_elim) const;
-    int calculateColumnTransitions(const Board& board_after_elim) const;
-    void calculateHolesAndDepth(const Board& board_after_elim, int& holes_count, int& total_hole_depth, int& rows_with_holes_count) const;
-    int calculateBoardWells(const Board& board_after_elim) const;
-    std::vector<int> calculateColumnHeights(const Board& board_after_elim) const;
-    std::vector<int> calculateColumnDifferences(const std::vector<int>& column_heights) const;
-    int calculateMaximumHeight(const std::vector<int>& column_heights) const;
+    // Row/column transitions, holes, hole depth, rows with holes and wells, only the parts `plan` asks for
+    void calculateBoardFeatures(const BitRows& bits_after_elim, const FeaturePlan& plan, Features& f) const;
+    void calculateColumnHeights(const BitRows& bits_after_elim, Features& f) const;
+    int calculateMaximumHeight(const Features& f) const;
 
-    // Helper to check if a line is full
-    bool isFullLine(const std::vector<const Block*>& line, int width) const;
+    // Row masks and column tops of the board every candidate is placed on
+    struct BaseBoard {
+        BitRows bits;
+        std::array<int, k_max_board_width> column_tops {};
+    };
+    void loadBase(const Board& board, BaseBoard& base) const;
+    void loadBase(const BitRows& bits, BaseBoard& base) const;
+    // Batch body shared by both extractFeaturesBatch overloads
+    void extractBatch(BaseBoard& base, const std::vector<BlockStatus>& actions, int num_features, FeatureMask mask, FeatureBatch& out, PlacementBatch* placements) const;
+    // Landing row computed from the column tops (same as findYOffset); fills `piece`.
+    int landingRow(const BaseBoard& base, const BlockStatus& action, PiecePlacement& piece) const;
+    // Evaluates the placement through `overlay` (laid over base.bits) and fills the parts
+    // of `f` that `plan` asks for, and `placed` (if not null) with the landing row and the
+    // post-clear rows. Returns false if the action cannot be placed (findYOffset == -1).
+    bool computeFeatures(const BaseBoard& base, PlacementOverlay& overlay, const BlockStatus& action, const FeaturePlan& plan, Features& f,
+        int* landing_row = nullptr, BitRows* placed = nullptr) const;
+    // Feature `index` in the order returned by extractFeatures
+    static int featureValue(const Features& f, int index);
 
 
 public:
     // Override the pure virtual function from the base class
     std::vector<int> extractFeatures(const Game& game, const BlockStatus& action) const override;
+    // Native batch path: no virtual call or vector allocation per candidate, and features
+    // outside `mask` are not computed. `placements` are copied out of the same overlay.
+    void extractFeaturesBatch(const Game& game, const std::vector<BlockStatus>& actions, int num_features, FeatureMask mask, FeatureBatch& out, PlacementBatch* placements) const override;
+    // Only needs row occupancy, so search snapshots are supported
+    void extractFeaturesBatch(const GameState& state, const std::vector<BlockStatus>& actions, int num_features, FeatureMask mask, FeatureBatch& out, PlacementBatch* placements) const override;
+    bool supportsGameState() const override { return true; }
+    // Core features 0..7, then the extended features of the Python extractor:
+    // width column heights, width - 1 adjacent height differences, maximum height
+    static constexpr int k_num_core_features = 8;
+    static constexpr int numFeatures(int board_width) { return k_num_core_features + 2 * board_width; }
     // Helper to get full lines (needed for eroded cells)
     std::vector<int> getFullLines(const Board& board) const;
     // void ensureNoNullLine(std::vector<std::vector<const Block *>>& squares) const;
@@ -58,5 +93,7 @@ public:
 
 extern int findYOffset(const Board& board, const BlockStatus& action);
 extern int eliminateLines(Board& board); // Declaration, definition might be in game.cpp or here
+// Only checks rows [y_begin, y_end) for fullness, e.g. the rows a piece was just placed in
+extern int eliminateLines(Board& board, int y_begin, int y_end);
 
 #endif // EXTRACTOR_H
\ No newline at end of file
@@ -1,9 +1,14 @@
 #include "game.h"
 #include "constants.h" // Include k_blocks declaration
 #include "extractor.h" // Include MyDbtFeatureExtractorCpp AND getBlockFromRotation declaration
+#include "game_state.h"
+#include "instrumentation.h"
 #include "models.h"
+#include "search_pool.h"
+#include "trace.h"
 #include <algorithm> // For std::max_element
 #include <chrono>
+#include <iostream>
 #include <limits> // For std::numeric_limits
 #include <memory> // For std::make_unique
 #include <numeric> // For std::inner_product
@@ -13,9 +18,19 @@
 #include <vector>
 
 // --- Random Number Generation ---
-// Use a static generator for reproducibility if needed, or thread-local for multi-threading.
-// For simplicity, a global static generator here.
-static std::mt19937 rng(std::random_device {}());
+// One generator per thread: training runs many games concurrently, and each game can
+// fix its piece sequence with seedPieceGenerator().
+static thread_local std::mt19937 rng(std::random_device {}());
+
+void seedPieceGenerator(std::uint32_t seed)
+{
+    rng.seed(seed);
+}
+
+std::mt19937& pieceGenerator()
+{
+    return rng;
+}
 
 // Helper to get a random block
 const Block* getRandomBlock()
@@ -35,10 +50,12 @@ Game createNewGame()
     // No need to copy blocks for config if GameConfig doesn't require owning copies
     // Assuming GameConfig can just store awards or other simple config.
     // If GameConfig *needs* available_blocks, it should store const Block*
-    GameConfig config({ 1.0, 3.0, 5.0, 8.0 }, {}); // Pass empty block list or adjust GameConfig
+    // One config shared by every game (thread-safe static init)
+    static const std::shared_ptr<const GameConfig> config = std::make_shared<const GameConfig>(
+        std::vector<double> { 1.0, 3.0, 5.0, 8.0 }, std::vector<Block> {}); // Pass empty block list or adjust GameConfig
     Board board(Size(10, 14)); // Standard Tetris size (adjust height as needed)
     std::vector<const Block*> initial_upcoming; // Empty initial upcoming blocks (pointers)
-    return Game(std::move(config), std::move(board), 0, std::move(initial_upcoming)); // Initial score 0
+    return Game(config, std::move(board), 0, std::move(initial_upcoming)); // Initial score 0
 }
 
 double calculateLinearFunction(const std::vector<double>& weights, const std::vector<int>& features)
@@ -88,8 +105,46 @@ std::vector<BlockStatus> getAllActions(const Block& block, int board_width)
     return actions;
 }
 
-BlockStatus findBestAction(const Game& game, const std::vector<BlockStatus>& actions, const AssessmentModel& model)
+void scoreFeatureBatch(const std::vector<double>& weights, const FeatureBatch& batch, std::vector<double>& scores)
+{
+    scores.assign(batch.count, 0.0);
+    int num_features = std::min(batch.num_features, static_cast<int>(weights.size()));
+    double* out = scores.data();
+    // Feature-major loop: each pass is a contiguous multiply-add over all candidates
+    for (int f = 0; f < num_features; ++f) {
+        const double w = weights[f];
+        if (w == 0.0) continue; // Column may not have been extracted (FeatureMask)
+        const int* column = batch.column(f);
+        for (int i = 0; i < batch.count; ++i) {
+            out[i] += w * column[i];
+        }
+    }
+    for (int i = 0; i < batch.count; ++i) {
+        if (!batch.valid[i]) {
+            out[i] = -std::numeric_limits<double>::infinity();
+        }
+    }
+}
+
+namespace {
+
+// Shared by the Game and GameState overloads below
+template <class Position>
+void evaluatePlacementsImpl(const Position& position, const std::vector<BlockStatus>& actions, const AssessmentModel& model, FeatureBatch& batch, std::vector<double>& scores,
+    PlacementBatch* placements = nullptr)
 {
+    if (!model.feature_extractor) {
+        throw std::runtime_error("AssessmentModel has no feature extractor.");
+    }
+    // Zero-weight features are not computed at all
+    model.feature_extractor->extractFeaturesBatch(position, actions, model.numFeatures(), model.featureMask(), batch, placements);
+    scoreFeatureBatch(model.weights, batch, scores);
+}
+
+template <class Position>
+BlockStatus findBestActionImpl(const Position& position, const std::vector<BlockStatus>& actions, const AssessmentModel& model)
+{
+    TETRIS_PROBE(k_probe_find_best_action);
     if (actions.empty()) {
         throw std::runtime_error("No actions provided to findBestAction.");
     }
@@ -97,60 +152,73 @@ BlockStatus findBestAction(const Game& game, const std::vector<BlockStatus>& act
         throw std::runtime_error("AssessmentModel has no feature extractor.");
     }
 
-    std::optional<BlockStatus> best_action_opt; // Use optional to handle no valid actions found initially
-    double best_score = -std::numeric_limits<double>::infinity();
-
-    // Use const& in the loop
-    for (const auto& current_action : actions) {
-        if (!current_action.rotation) continue; // Skip if rotation pointer is null
+    // Scratch buffers reused across calls on the same thread
+    static thread_local FeatureBatch batch;
+    static thread_local std::vector<double> scores;
+    evaluatePlacementsImpl(position, actions, model, batch, scores);
+
+    // First valid action wins ties, same as the old per-action loop
+    int best_index = -1;
+    for (int i = 0; i < batch.count; ++i) {
+        if (!batch.valid[i]) continue;
+        if (best_index == -1 || scores[i] > scores[best_index]) {
+            best_index = i;
+        }
+    }
 
-        double current_score = -std::numeric_limits<double>::infinity();
-        std::optional<double> score_opt = std::nullopt; // To store the calculated score
+    if (best_index == -1) {
+        // This means *every* action was an invalid placement
+        throw std::runtime_error("No valid actions found - game likely over.");
+    }
 
-        try {
-            std::vector<int> features = model.feature_extractor->extractFeatures(game, current_action);
-            size_t len_to_use = std::min(static_cast<size_t>(model.length), features.size());
-            len_to_use = std::min(len_to_use, model.weights.size());
+    BlockStatus best_action = actions[best_index];
+    best_action.assessment_score = scores[best_index];
+    return best_action;
+}
 
-            if (len_to_use > 0) {
-                 current_score = std::inner_product(model.weights.begin(), model.weights.begin() + len_to_use,
-                                                   features.begin(), 0.0);
-            } else {
-                 current_score = 0.0;
-            }
+// Second-ply node for extractors without GameState support: a copy of `game` with
+// `action` placed at `y_offset` and lines cleared. Cell colours and the config are kept.
+Game placeOnCopy(const Game& game, const BlockStatus& action, int y_offset)
+{
+    const Block* block = getBlockFromRotation(action.rotation);
+    if (!block) {
+        throw std::runtime_error("Could not determine block type for action1 in V2 sim.");
+    }
+    Game child = game;
+    for (const auto& pos : action.rotation->occupied) {
+        child.board.setCell(action.x_offset + pos.x, y_offset + pos.y, block);
+    }
+    eliminateLines(child.board, y_offset, y_offset + action.rotation->size.height);
+    return child;
+}
 
-            score_opt = current_score; // Store the valid score
+} // namespace
 
-        } catch (const std::runtime_error& e) {
-            // Feature extraction failed (e.g., invalid placement)
-            current_score = -std::numeric_limits<double>::infinity();
-            // score_opt remains nullopt
-        }
+void evaluatePlacements(const Game& game, const std::vector<BlockStatus>& actions, const AssessmentModel& model, FeatureBatch& batch, std::vector<double>& scores,
+    PlacementBatch* placements)
+{
+    evaluatePlacementsImpl(game, actions, model, batch, scores, placements);
+}
 
-        if (current_score > best_score) {
-            best_score = current_score;
-            best_action_opt = current_action; // Copy the action here as it's the new best
-            if (best_action_opt) { // Check if copy succeeded (should always)
-                 best_action_opt->assessment_score = score_opt; // Store the score in the best action copy
-            }
-        } else if (!best_action_opt.has_value() && score_opt.has_value()) {
-             // Initialize best_action_opt with the first valid action found
-             best_score = current_score;
-             best_action_opt = current_action;
-             best_action_opt->assessment_score = score_opt;
-        }
-    }
+void evaluatePlacements(const GameState& state, const std::vector<BlockStatus>& actions, const AssessmentModel& model, FeatureBatch& batch, std::vector<double>& scores,
+    PlacementBatch* placements)
+{
+    evaluatePlacementsImpl(state, actions, model, batch, scores, placements);
+}
 
-    if (!best_action_opt) {
-        // This means *every* action resulted in an exception from extractFeatures or had null rotation
-        throw std::runtime_error("No valid actions found - game likely over.");
-    }
+BlockStatus findBestAction(const Game& game, const std::vector<BlockStatus>& actions, const AssessmentModel& model)
+{
+    return findBestActionImpl(game, actions, model);
+}
 
-    return best_action_opt.value();
+BlockStatus findBestAction(const GameState& state, const std::vector<BlockStatus>& actions, const AssessmentModel& model)
+{
+    return findBestActionImpl(state, actions, model);
 }
 
 BlockStatus findBestActionV2(const Game& game, const std::vector<BlockStatus>& actions1, const Block& block2, const AssessmentModel& model)
 {
+    TETRIS_PROBE(k_probe_find_best_action_v2);
     if (actions1.empty()) {
         throw std::runtime_error("No actions1 provided to findBestActionV2.");
     }
@@ -158,11 +226,28 @@ BlockStatus findBestActionV2(const Game& game, const std::vector<BlockStatus>& a
         throw std::runtime_error("AssessmentModel has no feature extractor for findBestActionV2.");
     }
 
+    // Search nodes are GameState copies; action tables and feature buffers come from the
+    // thread's scratch pool, so the search does no heap allocation per node once it is warm.
+    // Extractors that need more than row occupancy get Game copies for the second ply instead.
+    const bool native_state = model.feature_extractor->supportsGameState();
+    SearchScratchPool& pool = SearchScratchPool::local();
+    GameState root;
+    captureState(game, root);
+    const std::vector<BlockStatus>& actions2 = pool.actionsFor(block2, game.board.size.width); // Use original board width
+
+    // Evaluate every first action (action1) in the current game state in one batch; the
+    // extractor also hands back each resulting board, so the first ply is placed only once
+    FeatureBatch& batch1 = pool.plyBatch(0);
+    std::vector<double>& scores1 = pool.plyScores(0);
+    PlacementBatch& placements1 = pool.plyPlacements(0);
+    evaluatePlacements(game, actions1, model, batch1, scores1, &placements1);
+
     double best_combined_score = -std::numeric_limits<double>::infinity();
     std::optional<BlockStatus> best_action1_opt;
 
     // Use const& in the loop
-    for (const auto& action1 : actions1) {
+    for (size_t i = 0; i < actions1.size(); ++i) {
+        const auto& action1 = actions1[i];
         if (!action1.rotation) continue; // Skip null rotation
 
         double score1 = -std::numeric_limits<double>::infinity();
@@ -170,23 +255,18 @@ BlockStatus findBestActionV2(const Game& game, const std::vector<BlockStatus>& a
         double current_combined_score = -std::numeric_limits<double>::infinity();
         std::optional<double> score1_opt = std::nullopt;
 
+        if (!batch1.valid[i]) {
+            // action1 itself cannot be placed
+            goto compare_scores_v2;
+        }
+
         try {
-            // 1. Evaluate the first action (action1) in the current game state
-            std::vector<int> features1 = model.feature_extractor->extractFeatures(game, action1);
-            size_t len_to_use1 = std::min(static_cast<size_t>(model.length), features1.size());
-            len_to_use1 = std::min(len_to_use1, model.weights.size());
-
-            if (len_to_use1 > 0) {
-                 score1 = std::inner_product(model.weights.begin(), model.weights.begin() + len_to_use1,
-                                            features1.begin(), 0.0);
-            } else {
-                 score1 = 0.0;
-            }
+            // 1. Score of the first action
+            score1 = scores1[i];
             score1_opt = score1;
 
-            // 2. Simulate placing action1 on a *copy of the board*
-            Board board1 = game.board; // Copy only the board
-            int y_offset1 = findYOffset(game.board, action1); // Find offset on original board
+            // 2. Board after action1, as computed by the extractor
+            int y_offset1 = placements1.landing_rows[i];
 
             if (y_offset1 == -1) {
                 // Action1 itself causes overflow/collision, treat as invalid path
@@ -195,54 +275,28 @@ BlockStatus findBestActionV2(const Game& game, const std::vector<BlockStatus>& a
                 goto compare_scores_v2; // Use goto for efficiency here
             }
 
-            // Get the original block pointer for action1
-            const Block* block_to_place1 = getBlockFromRotation(action1.rotation);
-             if (!block_to_place1) {
-                 throw std::runtime_error("Could not determine block type for action1 in V2 sim.");
-             }
-
-            // Place block on the copied board
-            for (const auto& pos : action1.rotation->occupied) { // Use ->
-                int place_x = action1.x_offset + pos.x;
-                int place_y = y_offset1 + pos.y;
-                if (place_y >= 0 && place_y < board1.getGridHeight() && place_x >= 0 && place_x < board1.size.width) {
-                    board1.squares[place_y][place_x] = block_to_place1; // Place pointer
-                } else {
-                     // This indicates a logic error if findYOffset/isOverflow worked correctly
-                     throw std::logic_error("Placement out of bounds during V2 simulation.");
-                }
-            }
-
-            // Eliminate lines on the copied board
-            eliminateLines(board1); // Modifies board1
+            GameState state1 = root; // Trivially copyable: a memcpy, no allocation
+            state1.board = placements1.boards[i];
 
             // Check for game over *after* placing action1 and clearing lines
-            bool game_over_after_action1 = false;
-             for (int y = game.board.size.height; y < board1.getGridHeight(); ++y) { // Check buffer zone
-                 for (int x = 0; x < board1.size.width; ++x) {
-                     if (board1.squares[y][x] != nullptr) {
-                         game_over_after_action1 = true;
-                         break;
-                     }
-                 }
-                 if (game_over_after_action1) break;
-             }
+            bool game_over_after_action1 = hasBlocksInBuffer(state1.board);
 
             if (!game_over_after_action1) {
-                // Create a temporary Game object using the *moved* board1.
-                // GameConfig copy should be cheap or Game needs a constructor taking const GameConfig&.
-                // Assume GameConfig copy is acceptable for now.
-                 std::vector<const Block*> next_upcoming_sim = { &block2, getRandomBlock() }; // Simplified next state
-                 Game game1_sim(game.config, std::move(board1), game.score, std::move(next_upcoming_sim));
-                 // Note: score isn't updated, config is copied, board1 is moved.
-
-                auto actions2 = getAllActions(block2, game.board.size.width); // Use original board width
+                // Simplified next state; the score isn't updated
+                state1.preview = { &block2, getRandomBlock() };
+
                 if (!actions2.empty()) {
                     try {
                         // Call findBestAction with the simulated game state
-                        BlockStatus best_action2 = findBestAction(game1_sim, actions2, model);
+                        BlockStatus best_action2 = [&] {
+                            if (native_state) return findBestAction(state1, actions2, model);
+                            Game game1 = placeOnCopy(game, action1, y_offset1);
+                            game1.upcoming_blocks = { state1.preview[0], state1.preview[1] };
+                            return findBestAction(game1, actions2, model);
+                        }();
                         score2 = best_action2.assessment_score.value_or(-std::numeric_limits<double>::infinity());
                     } catch (const std::runtime_error& e) {
+                         TETRIS_COUNT(k_counter_exceptions, 1);
                          // If findBestAction throws (e.g., no valid moves for block2), score2 remains -inf
                          score2 = -std::numeric_limits<double>::infinity();
                     }
@@ -259,7 +313,8 @@ BlockStatus findBestActionV2(const Game& game, const std::vector<BlockStatus>& a
             current_combined_score = score1 + score2;
 
         } catch (const std::runtime_error& e) {
-            // Catch errors during feature extraction for action1 itself
+            TETRIS_COUNT(k_counter_exceptions, 1);
+            // Catch errors during the simulation of action1
             score1 = -std::numeric_limits<double>::infinity();
             score2 = -std::numeric_limits<double>::infinity();
             current_combined_score = -std::numeric_limits<double>::infinity();
@@ -301,6 +356,7 @@ BlockStatus findBestActionV2(const Game& game, const std::vector<BlockStatus>& a
 // Modifies game state directly, returns y_offset
 int executeAction(Game& game, const BlockStatus& action)
 {
+    TETRIS_PROBE(k_probe_execute_action);
     if (!action.rotation) {
          throw std::runtime_error("Game Over: executeAction called with null rotation.");
     }
@@ -327,7 +383,7 @@ int executeAction(Game& game, const BlockStatus& action)
         int place_y = y_offset + pos.y;
         // Bounds check
         if (place_y >= 0 && place_y < board.getGridHeight() && place_x >= 0 && place_x < board.size.width) {
-            board.squares[place_y][place_x] = block_to_place; // Place pointer
+            board.setCell(place_x, place_y, block_to_place); // Place pointer
         } else {
             // This indicates a logic error, potentially in findYOffset or action generation
             game.setEnd(); // Set game over state
@@ -336,25 +392,22 @@ int executeAction(Game& game, const BlockStatus& action)
     }
 
     // 4. Eliminate lines and update score on the game's board
-    int eliminated_lines = eliminateLines(board); // Modifies the game's board
+    // Only the rows the piece occupies can have become full
+    int eliminated_lines = eliminateLines(board, y_offset, y_offset + action.rotation->size.height); // Modifies the game's board
 
     if (eliminated_lines > 0) {
-        if (eliminated_lines <= static_cast<int>(game.config.awards.size())) {
-            game.score += static_cast<int>(game.config.awards[eliminated_lines - 1] * 100);
-        } else if (!game.config.awards.empty()) {
-            game.score += static_cast<int>(game.config.awards.back() * 100 * eliminated_lines);
+        if (eliminated_lines <= static_cast<int>(game.config->awards.size())) {
+            game.score += static_cast<int>(game.config->awards[eliminated_lines - 1] * 100);
+        } else if (!game.config->awards.empty()) {
+            game.score += static_cast<int>(game.config->awards.back() * 100 * eliminated_lines);
         }
     }
 
      // Check for game over AFTER placement and line clearing (block above ceiling)
-     for (int y = game.board.size.height; y < board.getGridHeight(); ++y) { // Check buffer zone
-         for (int x = 0; x < board.size.width; ++x) {
-             if (board.squares[y][x] != nullptr) {
-                 game.setEnd();
-                 // Return offset even if game ended here, main loop checks isEnd()
-                 return y_offset;
-             }
-         }
+     if (board.hasBlocksInBuffer()) {
+         game.setEnd();
+         // Return offset even if game ended here, main loop checks isEnd()
+         return y_offset;
      }
 
     // 5. Update upcoming blocks in the game state (now returns pointers)
@@ -405,11 +458,15 @@ int runGame(Context& ctx)
             BlockStatus best_action = findBestAction(ctx.game, actions, *ctx.strategy.assessment_model);
 
             // 3. Execute best action (modifies ctx.game directly)
+            if (ctx.trace) {
+                ctx.trace->recordMove(ctx.game, best_action);
+            }
             executeAction(ctx.game, best_action); // Modifies ctx.game
 
             // Loop continues until game.isEnd() is true or an exception occurs
         }
     } catch (const std::runtime_error& e) {
+        TETRIS_COUNT(k_counter_exceptions, 1);
         // Catch exceptions from findBestAction (no valid moves) or executeAction (overflow)
         // These indicate a game over condition.
         // Ensure game score is negative.
@@ -418,6 +475,7 @@ int runGame(Context& ctx)
         }
         // Optionally log: std::cerr << "Game ended with error: " << e.what() << std::endl;
     } catch (const std::exception& e) {
+        TETRIS_COUNT(k_counter_exceptions, 1);
         // Catch other potential standard exceptions
         if (!ctx.game.isEnd()) {
             ctx.game.setEnd();
@@ -425,12 +483,25 @@ int runGame(Context& ctx)
         // Optionally log: std::cerr << "Game ended with unexpected error: " << e.what() << std::endl;
     }
 
+    if (ctx.trace) {
+        ctx.trace->finish(ctx.game);
+    }
+
+#ifdef TETRIS_INSTRUMENT
+    TETRIS_COUNT(k_counter_games, 1);
+    if (instrument::perGameDump()) {
+        instrument::printSummary(std::cerr, instrument::local(), "runGame instrumentation");
+    }
+    instrument::mergeLocal();
+#endif
+
     // return std::abs(ctx.game.score); // Return absolute score
     return steps; // Return the number of steps taken, or final score if needed
 }
 
-int runGameForTraining(const std::vector<double>& weights)
+TrainingGameResult runGameForTraining(const std::vector<double>& weights, std::uint32_t seed)
 {
+    seedPieceGenerator(seed);
     auto feature_extractor = std::make_unique<MyDbtFeatureExtractorCpp>();
     int model_length = 8;
     // Ensure weights vector is copied for the model, or model takes const& if lifetime allows
@@ -443,5 +514,6 @@ int runGameForTraining(const std::vector<double>& weights)
     Strategy strategy(std::move(assessment_model));
     Context ctx(createNewGame(), std::move(strategy)); // createNewGame is updated
 
-    return runGame(ctx); // runGame is updated
+    int steps = runGame(ctx);
+    return { steps, ctx.game.score };
 }
\ No newline at end of file
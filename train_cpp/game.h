@@ -1,7 +1,10 @@
 #ifndef GAME_H
 #define GAME_H
 
+#include "game_state.h"
 #include "models.h"
+#include <cstdint>
+#include <random>
 #include <vector>
 #include <utility> // For std::pair
 
@@ -19,9 +22,23 @@ std::vector<const Block*> getNewUpcoming(Game& game); // Modifies game's random
 // Generates all possible actions (placements/rotations) for a given block.
 std::vector<BlockStatus> getAllActions(const Block& block, int board_width);
 
+// Scores every candidate of a feature batch in one pass (SoA dot product).
+// Invalid candidates get -infinity.
+void scoreFeatureBatch(const std::vector<double>& weights, const FeatureBatch& batch, std::vector<double>& scores);
+
+// Batched evaluation of a piece's whole placement table: fills `batch` with the features
+// of every action and `scores` with the model's linear score for each of them.
+// `placements`, if given, receives the board each action leaves behind (see PlacementBatch).
+void evaluatePlacements(const Game& game, const std::vector<BlockStatus>& actions, const AssessmentModel& model, FeatureBatch& batch, std::vector<double>& scores,
+    PlacementBatch* placements = nullptr);
+void evaluatePlacements(const GameState& state, const std::vector<BlockStatus>& actions, const AssessmentModel& model, FeatureBatch& batch, std::vector<double>& scores,
+    PlacementBatch* placements = nullptr);
+
 // Finds the best action from a list based on the assessment model.
 // Throws std::runtime_error if no valid action is found.
 BlockStatus findBestAction(const Game& game, const std::vector<BlockStatus>& actions, const AssessmentModel& model);
+// Same on a search snapshot (the model's extractor must support GameState)
+BlockStatus findBestAction(const GameState& state, const std::vector<BlockStatus>& actions, const AssessmentModel& model);
 
 BlockStatus findBestActionV2(const Game& game, const std::vector<BlockStatus>& actions1, const Block& block2, const AssessmentModel& model);
 
@@ -34,9 +51,21 @@ int executeAction(Game& game, const BlockStatus& action);
 // Returns the final score.
 int runGame(Context& ctx); // Modifies the context
 
+// Outcome of one training game
+struct TrainingGameResult {
+    int steps; // Pieces placed (runGame's return value, the training objective)
+    int score; // Line-clear score of the final position
+};
+
+// Reseeds the calling thread's piece generator; the same seed replays the same piece sequence.
+void seedPieceGenerator(std::uint32_t seed);
+// The calling thread's piece generator itself, so a game that owns its own sequence can
+// swap its generator in around getNewUpcoming() / executeAction() (see c_api.cpp).
+std::mt19937& pieceGenerator();
+
 // Runs a game specifically for training, taking weights directly.
-// Returns the final score.
-int runGameForTraining(const std::vector<double>& weights);
+// The piece sequence is fixed by `seed` (see seedPieceGenerator).
+TrainingGameResult runGameForTraining(const std::vector<double>& weights, std::uint32_t seed);
 
 
 // --- Helper function declarations (if needed externally, otherwise keep static in game.cpp) ---
@@ -0,0 +1,15 @@
+#include "game_state.h"
+
+void captureState(const Game& game, GameState& out)
+{
+    loadBitRows(game.board, out.board);
+    out.score = game.score;
+    out.preview[0] = game.upcoming_blocks.size() > 0 ? game.upcoming_blocks[0] : nullptr;
+    out.preview[1] = game.upcoming_blocks.size() > 1 ? game.upcoming_blocks[1] : nullptr;
+}
+
+void PlacementBatch::resize(int candidates)
+{
+    landing_rows.assign(candidates, -1);
+    boards.resize(candidates);
+}
@@ -0,0 +1,33 @@
+#ifndef GAME_STATE_H
+#define GAME_STATE_H
+
+#include "bitboard.h"
+#include "models.h"
+#include <array>
+#include <type_traits>
+#include <vector>
+
+// Compact snapshot of the mutable part of a Game, used as a search node: board occupancy as
+// row masks, score and the two-piece preview. The config stays behind the Game's shared
+// pointer and cell colours (the Block pointers in Board::squares) are dropped, so copying a
+// node is a plain memcpy. A GameState can be scored but not turned back into a Game.
+struct GameState {
+    BitRows board;
+    int score = 0;
+    std::array<const Block*, 2> preview {}; // upcoming_blocks[0..1], nullptr if missing
+};
+static_assert(std::is_trivially_copyable<GameState>::value, "GameState must stay trivially copyable");
+
+// Throws std::invalid_argument if the board exceeds the row-mask limits (see loadBitRows).
+void captureState(const Game& game, GameState& out);
+
+// Result of every candidate placement of an extractFeaturesBatch() call, handed back so a
+// search can expand a child node without placing the piece a second time.
+struct PlacementBatch {
+    std::vector<int> landing_rows; // findYOffset() of each candidate, -1 if it cannot be placed
+    std::vector<BitRows> boards;   // Rows after placing and clearing lines; only set where landing_rows[i] != -1
+
+    void resize(int candidates); // Reuses capacity
+};
+
+#endif // GAME_STATE_H
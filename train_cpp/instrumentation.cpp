@@ -0,0 +1,107 @@
+#include "instrumentation.h"
+#include <atomic>
+#include <iomanip>
+#include <mutex>
+
+namespace instrument {
+
+namespace {
+
+const char* const k_probe_names[k_probe_count] = {
+    "findYOffset",
+    "extractFeatures",
+    "eliminateLines",
+    "findBestAction",
+    "findBestActionV2",
+    "executeAction",
+};
+
+const char* const k_counter_names[k_counter_count] = {
+    "lines cleared",
+    "exceptions",
+    "games",
+};
+
+std::mutex g_global_mutex;
+Stats g_global_stats;
+std::atomic<bool> g_per_game_dump { true };
+
+} // namespace
+
+void Stats::reset()
+{
+    calls.fill(0);
+    nanos.fill(0);
+    counters.fill(0);
+}
+
+Stats& Stats::operator+=(const Stats& other)
+{
+    for (int i = 0; i < k_probe_count; ++i) {
+        calls[i] += other.calls[i];
+        nanos[i] += other.nanos[i];
+    }
+    for (int i = 0; i < k_counter_count; ++i) {
+        counters[i] += other.counters[i];
+    }
+    return *this;
+}
+
+Stats& local()
+{
+    static thread_local Stats stats;
+    return stats;
+}
+
+void mergeLocal()
+{
+    Stats& stats = local();
+    {
+        std::lock_guard<std::mutex> lock(g_global_mutex);
+        g_global_stats += stats;
+    }
+    stats.reset();
+}
+
+Stats globalSnapshot()
+{
+    std::lock_guard<std::mutex> lock(g_global_mutex);
+    return g_global_stats;
+}
+
+void setPerGameDump(bool enabled)
+{
+    g_per_game_dump.store(enabled, std::memory_order_relaxed);
+}
+
+bool perGameDump()
+{
+    return g_per_game_dump.load(std::memory_order_relaxed);
+}
+
+void printSummary(std::ostream& os, const Stats& stats, const char* title)
+{
+    std::ios::fmtflags old_flags = os.flags();
+    std::streamsize old_precision = os.precision();
+    char old_fill = os.fill(' ');
+    os << "--- " << title << " ---\n";
+    for (int i = 0; i < k_probe_count; ++i) {
+        if (stats.calls[i] == 0) continue;
+        double total_ms = static_cast<double>(stats.nanos[i]) / 1e6;
+        double avg_ns = static_cast<double>(stats.nanos[i]) / static_cast<double>(stats.calls[i]);
+        os << "  " << std::left << std::setw(18) << k_probe_names[i] << std::right
+           << " calls=" << std::setw(12) << stats.calls[i]
+           << " total=" << std::fixed << std::setprecision(2) << std::setw(10) << total_ms << "ms"
+           << " avg=" << std::setprecision(1) << avg_ns << "ns\n";
+    }
+    for (int i = 0; i < k_counter_count; ++i) {
+        os << "  " << std::left << std::setw(18) << k_counter_names[i] << std::right
+           << " " << stats.counters[i] << '\n';
+    }
+    os.flags(old_flags);
+    os.precision(old_precision);
+    os.fill(old_fill);
+    os.flush();
+}
+
+} // namespace instrument
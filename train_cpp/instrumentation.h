@@ -0,0 +1,91 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+// Lightweight per-thread counters and timers for the hot paths in game.cpp / extractor.cpp.
+// Everything is compiled in only when TETRIS_INSTRUMENT is defined (CMake option of the same
+// name); otherwise the TETRIS_* macros below expand to nothing.
+
+namespace instrument {
+
+enum Probe : int {
+    k_probe_find_y_offset = 0,
+    k_probe_extract_features,
+    k_probe_eliminate_lines,
+    k_probe_find_best_action,
+    k_probe_find_best_action_v2,
+    k_probe_execute_action,
+    k_probe_count
+};
+
+enum Counter : int {
+    k_counter_lines_cleared = 0,
+    k_counter_exceptions,
+    k_counter_games,
+    k_counter_count
+};
+
+struct Stats {
+    std::array<std::uint64_t, k_probe_count> calls {};
+    std::array<std::uint64_t, k_probe_count> nanos {};
+    std::array<std::uint64_t, k_counter_count> counters {};
+
+    void reset();
+    Stats& operator+=(const Stats& other);
+};
+
+// Stats of the calling thread (one instance per thread, no locking).
+Stats& local();
+
+// Adds the calling thread's stats to the process-wide totals and resets them.
+void mergeLocal();
+
+// Copy of the process-wide totals accumulated via mergeLocal().
+Stats globalSnapshot();
+
+// Whether runGame() prints a summary for every finished game (training turns this off).
+void setPerGameDump(bool enabled);
+bool perGameDump();
+
+void printSummary(std::ostream& os, const Stats& stats, const char* title);
+
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Probe probe)
+        : probe_(probe)
+        , start_(std::chrono::steady_clock::now())
+    {
+    }
+    ~ScopedTimer()
+    {
+        auto elapsed = std::chrono::steady_clock::now() - start_;
+        Stats& stats = local();
+        stats.calls[probe_]++;
+        stats.nanos[probe_] += static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    Probe probe_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace instrument
+
+#ifdef TETRIS_INSTRUMENT
+#define TETRIS_CONCAT_IMPL(a, b) a##b
+#define TETRIS_CONCAT(a, b) TETRIS_CONCAT_IMPL(a, b)
+#define TETRIS_PROBE(probe) ::instrument::ScopedTimer TETRIS_CONCAT(tetris_probe_, __LINE__)(::instrument::probe)
+#define TETRIS_COUNT(counter, n) (::instrument::local().counters[::instrument::counter] += static_cast<std::uint64_t>(n))
+#else
+#define TETRIS_PROBE(probe) ((void)0)
+#define TETRIS_COUNT(counter, n) ((void)0)
+#endif
+
+#endif // INSTRUMENTATION_H
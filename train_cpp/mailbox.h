@@ -0,0 +1,41 @@
+#ifndef MAILBOX_H
+#define MAILBOX_H
+
+#include <array>
+#include <atomic>
+
+// Single-producer / single-consumer mailbox that holds only the latest value (triple
+// buffering). The producer fills back() in place and publish()es it; the consumer take()s
+// the newest published value, silently skipping any it was too slow to see. Both sides are
+// wait-free: each owns one slot and they only exchange the third through an atomic index.
+template <class T>
+class LatestValueMailbox {
+public:
+    // Producer side
+    T& back() { return slots_[back_]; }
+    void publish()
+    {
+        back_ = middle_.exchange(back_ | k_fresh, std::memory_order_acq_rel) & k_index;
+    }
+
+    // Consumer side. Returns true and makes front() the newest value if one was published
+    // since the last call.
+    bool take()
+    {
+        if (!(middle_.load(std::memory_order_relaxed) & k_fresh)) return false;
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & k_index;
+        return true;
+    }
+    const T& front() const { return slots_[front_]; }
+
+private:
+    static constexpr unsigned k_index = 3;
+    static constexpr unsigned k_fresh = 4; // Set while the middle slot has not been taken
+
+    std::array<T, 3> slots_ {};
+    unsigned back_ = 0;  // Producer's slot
+    unsigned front_ = 1; // Consumer's slot
+    alignas(64) std::atomic<unsigned> middle_ { 2 };
+};
+
+#endif // MAILBOX_H
@@ -1,9 +1,12 @@
 #include "constants.h"
 #include "extractor.h"
 #include "game.h"
+#include "instrumentation.h"
 #include "models.h"
+#include "trace.h"
 #include "visualize.h" // Include the visualization header
 #include <algorithm>
+#include <cstdlib> // For std::atoi
 #include <iomanip>
 #include <iostream>
 #include <memory> // For std::make_unique
@@ -42,6 +45,14 @@ int main(int argc, char* argv[])
     Strategy strategy(std::move(assessment_model));
     Context ctx(std::move(game), std::move(strategy));
 
+    // -t <file>: record the game for tetris_replay
+    std::unique_ptr<TraceWriter> trace;
+    auto trace_arg = std::find(args.begin(), args.end(), std::string("-t"));
+    if (trace_arg != args.end() && trace_arg + 1 != args.end()) {
+        trace = std::make_unique<TraceWriter>(*(trace_arg + 1), ctx.game, *ctx.strategy.assessment_model);
+        std::cout << "Recording trace to " << *(trace_arg + 1) << std::endl;
+    }
+
     std::cout << "Initial Game Created. Score: " << ctx.game.score << std::endl;
     if (!ctx.game.upcoming_blocks.empty() && ctx.game.upcoming_blocks[0]) {
         std::cout << "First upcoming block: " << ctx.game.upcoming_blocks[0]->label << std::endl; // Use ->
@@ -51,6 +62,21 @@ int main(int argc, char* argv[])
     // std::cout << "cli args: " << args << std::endl;
 
     std::cout << "\n--- Simulating Steps ---" << std::endl;
+    // -v: live view, drawn in place by a render thread at --fps N frames per second (default 30)
+    // from snapshots the game loop publishes after every piece; the game runs at full speed
+    std::unique_ptr<LiveRenderer> live_view;
+    if (std::find(args.begin(), args.end(), std::string("-v")) != args.end()) {
+        int fps = 30;
+        auto fps_arg = std::find(args.begin(), args.end(), std::string("--fps"));
+        if (fps_arg != args.end() && fps_arg + 1 != args.end()) {
+            fps = std::max(1, std::atoi((fps_arg + 1)->c_str()));
+        }
+        live_view = std::make_unique<LiveRenderer>(fps);
+    }
+    // The render thread owns the terminal until then
+    auto stop_live_view = [&] {
+        if (live_view) live_view->stop();
+    };
     auto count = -1;
     auto delay = 300; // Delay in milliseconds
     for (int i = 0; i != count; i++) {
@@ -66,6 +92,7 @@ int main(int argc, char* argv[])
         }
 
         if (ctx.game.isEnd()) { // Check if game ended in the previous iteration
+             stop_live_view();
              std::cout << "-----------------------------------------" << std::endl;
              std::cout << "GAME OVER detected at start of step " << i + 1 << std::endl;
              std::cout << "Final Score: " << ctx.game.score << std::endl;
@@ -78,6 +105,7 @@ int main(int argc, char* argv[])
                 // Attempt to get new blocks if empty (shouldn't happen with proper executeAction)
                 ctx.game.upcoming_blocks = getNewUpcoming(ctx.game);
                 if (ctx.game.upcoming_blocks.empty()) {
+                    stop_live_view();
                     std::cout << "No upcoming blocks to play and cannot get new ones." << std::endl;
                     ctx.game.setEnd(); // Ensure game is marked as over
                     break; // Exit loop
@@ -91,6 +119,7 @@ int main(int argc, char* argv[])
             std::vector<BlockStatus> actions = getAllActions(current_block, ctx.game.board.size.width);
 
             if (actions.empty()) {
+                stop_live_view();
                 std::cout << "No possible actions for the current block." << std::endl;
                 ctx.game.setEnd(); // Mark game as over
                 break; // Exit loop
@@ -105,6 +134,9 @@ int main(int argc, char* argv[])
             BlockStatus best_action = findBestAction(ctx.game, actions, *ctx.strategy.assessment_model);
 
             // Execute the action (modifies ctx.game directly)
+            if (trace) {
+                trace->recordMove(ctx.game, best_action);
+            }
             int y_offset = executeAction(ctx.game, best_action); // Returns offset, modifies ctx.game
 
             // Post-action checks and logging
@@ -113,7 +145,7 @@ int main(int argc, char* argv[])
                 // Logging handled within the loop break condition at the start of the next iteration
             } else {
                 // Action was successful
-                if (i % 1000 == 0) {
+                if (i % 1000 == 0 && !live_view) {
                     // Get current time
                     auto now = std::chrono::system_clock::now();
                     auto now_c = std::chrono::system_clock::to_time_t(now);
@@ -128,8 +160,8 @@ int main(int argc, char* argv[])
                     std::cout << i << " - New Score: " << ctx.game.score << std::endl;
                 }
 
-                if (std::find(args.begin(), args.end(), std::string("-v")) != args.end()) {
-                    visualizeGame(ctx.game, best_action, y_offset, true); // Show board
+                if (live_view) {
+                    live_view->publish(ctx.game, best_action, y_offset, i + 1);
                 }
                  // Optional: Log next block
                  // if (!ctx.game.upcoming_blocks.empty() && ctx.game.upcoming_blocks[0]) {
@@ -139,6 +171,7 @@ int main(int argc, char* argv[])
 
         } catch (const std::runtime_error& e) {
             // Handle exceptions from findBestActionV2 or executeAction
+            stop_live_view();
             std::string error_msg = e.what();
             std::cout << "-----------------------------------------" << std::endl;
             std::cout << "GAME OVER: " << error_msg << std::endl;
@@ -150,6 +183,7 @@ int main(int argc, char* argv[])
             break; // Exit the simulation loop
         } catch (const std::exception& e) {
             // Handle other exceptions
+             stop_live_view();
              std::cerr << "Unexpected error: " << e.what() << std::endl;
              if (!ctx.game.isEnd()) {
                  ctx.game.setEnd();
@@ -158,10 +192,20 @@ int main(int argc, char* argv[])
         }
     }
 
+    stop_live_view();
     // Final check in case loop exited without setting score message
     if (ctx.game.isEnd()) {
          std::cout << "Simulation ended. Final Score: " << ctx.game.score << std::endl;
     }
+    if (trace) {
+        trace->finish(ctx.game);
+        std::cout << "Trace: " << trace->moves() << " moves recorded." << std::endl;
+    }
+
+#ifdef TETRIS_INSTRUMENT
+    TETRIS_COUNT(k_counter_games, 1);
+    instrument::printSummary(std::cout, instrument::local(), "tetris_test instrumentation");
+#endif
 
     std::cout << "\n--- Test Finished ---" << std::endl;
     return 0;
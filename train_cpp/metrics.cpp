@@ -0,0 +1,80 @@
+#include "metrics.h"
+#include <stdexcept>
+#include <utility>
+
+MetricsSink::MetricsSink(const std::string& path, size_t batch_size)
+    : file_(std::fopen(path.c_str(), "ab"))
+    , batch_size_(batch_size > 0 ? batch_size : 1)
+{
+    if (!file_) {
+        throw std::runtime_error("Cannot open metrics file: " + path);
+    }
+    std::fseek(file_, 0, SEEK_END); // Append mode need not start at the end until the first write
+    if (std::ftell(file_) == 0) {
+        std::fputs("params_id,game,seed,score,pieces,wall_ms\n", file_);
+    }
+    batch_.reserve(batch_size_);
+    writer_ = std::thread(&MetricsSink::writerLoop, this);
+}
+
+MetricsSink::~MetricsSink()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!batch_.empty()) pending_.push_back(std::move(batch_));
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    writer_.join();
+    std::fclose(file_);
+}
+
+void MetricsSink::record(const GameRecord& row)
+{
+    bool full;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        batch_.push_back(row);
+        full = batch_.size() >= batch_size_;
+        if (full) {
+            pending_.push_back(std::move(batch_));
+            batch_ = std::vector<GameRecord>();
+            batch_.reserve(batch_size_);
+        }
+    }
+    if (full) wake_.notify_one();
+}
+
+void MetricsSink::flush()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!batch_.empty()) {
+        pending_.push_back(std::move(batch_));
+        batch_ = std::vector<GameRecord>();
+    }
+    wake_.notify_one();
+    drained_.wait(lock, [this] { return pending_.empty() && !writing_; });
+}
+
+void MetricsSink::writerLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        wake_.wait(lock, [this] { return stopping_ || !pending_.empty(); });
+        if (pending_.empty()) break; // Stopping and nothing left
+
+        std::vector<std::vector<GameRecord>> batches = std::move(pending_);
+        pending_.clear();
+        writing_ = true;
+        lock.unlock();
+        for (const auto& batch : batches) {
+            for (const GameRecord& r : batch) {
+                std::fprintf(file_, "%u,%u,%u,%d,%d,%.3f\n", r.params_id, r.game, r.seed, r.score, r.pieces, r.wall_ms);
+            }
+        }
+        std::fflush(file_);
+        lock.lock();
+        writing_ = false;
+        drained_.notify_all();
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// One evaluated training game
+struct GameRecord {
+    std::uint32_t params_id; // iteration * population size + candidate index
+    std::uint32_t game;      // Game number within the candidate's evaluation
+    std::uint32_t seed;      // Piece generator seed (seedPieceGenerator) to replay the game
+    int score;
+    int pieces;
+    double wall_ms;
+};
+
+// Appends one CSV row per game to a file:
+//     params_id,game,seed,score,pieces,wall_ms
+// record() only copies the row into the current batch; full batches are formatted and
+// written by a background thread, so evaluation threads never wait on the disk.
+class MetricsSink {
+public:
+    // Appends to `path` (writing the header if the file is new or empty).
+    // Throws std::runtime_error if the file cannot be opened.
+    explicit MetricsSink(const std::string& path, size_t batch_size = 256);
+    // Writes the remaining rows and stops the writer thread
+    ~MetricsSink();
+    MetricsSink(const MetricsSink&) = delete;
+    MetricsSink& operator=(const MetricsSink&) = delete;
+
+    void record(const GameRecord& row); // Thread-safe
+    void flush(); // Blocks until every recorded row is written to the file
+
+private:
+    void writerLoop();
+
+    std::FILE* file_;
+    size_t batch_size_;
+    std::mutex mutex_;
+    std::condition_variable wake_;    // Writer: a batch is ready or stopping
+    std::condition_variable drained_; // flush(): pending batches written
+    std::vector<GameRecord> batch_;
+    std::vector<std::vector<GameRecord>> pending_;
+    bool writing_ = false;
+    bool stopping_ = false;
+    std::thread writer_;
+};
+
+#endif // METRICS_H
@@ -1,5 +1,8 @@
 #include "models.h" // Include the header file
-#include <algorithm> // For std::all_of
+#include "bitboard.h" // k_max_board_width, k_max_grid_rows
+#include "extractor.h" // findYOffset
+#include "game_state.h"
+#include <algorithm> // For std::min
 #include <stdexcept>
 #include <utility> // For std::move
 
@@ -80,7 +83,46 @@ BlockStatus::BlockStatus(int offset, const BlockRotation* rot, std::optional<dou
 }
 
 // --- Strategy & AI Related Classes Implementation ---
-// FeatureExtractor is abstract, no implementation here
+
+void FeatureBatch::resize(int features, int candidates)
+{
+    num_features = features;
+    count = candidates;
+    values.assign(static_cast<size_t>(features) * candidates, 0);
+    valid.assign(candidates, 0);
+}
+
+// Fallback for extractors without a native batch path
+void FeatureExtractor::extractFeaturesBatch(const Game& game, const std::vector<BlockStatus>& actions, int num_features, FeatureMask, FeatureBatch& out, PlacementBatch* placements) const
+{
+    out.resize(num_features, static_cast<int>(actions.size()));
+    if (placements) {
+        placements->resize(out.count);
+    }
+    for (int i = 0; i < out.count; ++i) {
+        try {
+            std::vector<int> features = extractFeatures(game, actions[i]);
+            int n = std::min(num_features, static_cast<int>(features.size()));
+            for (int f = 0; f < n; ++f) {
+                out.column(f)[i] = features[f];
+            }
+            out.valid[i] = 1;
+            if (placements) {
+                int y_offset = findYOffset(game.board, actions[i]);
+                placements->landing_rows[i] = y_offset;
+                loadBitRows(game.board, placements->boards[i]);
+                applyPlacement(placements->boards[i], makePiecePlacement(*actions[i].rotation, actions[i].x_offset, y_offset));
+            }
+        } catch (const std::runtime_error&) {
+            out.valid[i] = 0; // Invalid placement, column entries stay 0
+        }
+    }
+}
+
+void FeatureExtractor::extractFeaturesBatch(const GameState&, const std::vector<BlockStatus>&, int, FeatureMask, FeatureBatch&, PlacementBatch*) const
+{
+    throw std::logic_error("This feature extractor cannot evaluate GameState snapshots.");
+}
 
 AssessmentModel::AssessmentModel(int len, std::vector<double> w, std::unique_ptr<FeatureExtractor> extractor)
     : length(len)
@@ -89,6 +131,26 @@ AssessmentModel::AssessmentModel(int len, std::vector<double> w, std::unique_ptr
 {
 }
 
+int AssessmentModel::numFeatures() const
+{
+    return std::max(0, std::min(length, static_cast<int>(weights.size())));
+}
+
+FeatureMask AssessmentModel::featureMask() const
+{
+    FeatureMask mask = 0;
+    int n = numFeatures();
+    for (int f = 0; f < n; ++f) {
+        if (f >= k_max_masked_features) {
+            break; // Always computed
+        }
+        if (weights[f] != 0.0) {
+            mask |= FeatureMask(1) << f;
+        }
+    }
+    return mask;
+}
+
 Strategy::Strategy(std::unique_ptr<AssessmentModel> model)
     : assessment_model(std::move(model))
 {
@@ -105,15 +167,22 @@ GameConfig::GameConfig(std::vector<double> awds, std::vector<Block> blocks)
 Board::Board(Size s)
     : size(s)
 {
-    int buffer_height = 5;
-    int total_height = size.height + buffer_height;
+    int total_height = size.height + k_buffer_height;
+    // Same limits as the row-mask kernels, so every Board can be loaded into a BitRows
+    static_assert(k_max_grid_rows <= 64, "eliminateLines() tracks full rows in a 64-bit set");
+    if (size.width < 0 || size.width > k_max_board_width || size.height < 0 || total_height > k_max_grid_rows) {
+        throw std::invalid_argument("Board size out of range (width <= " + std::to_string(k_max_board_width)
+            + ", height + buffer <= " + std::to_string(k_max_grid_rows) + ").");
+    }
     squares.resize(total_height, std::vector<const Block*>(size.width, nullptr));
+    row_masks.resize(total_height, 0);
 }
 
 // Copy constructor
 Board::Board(const Board& other)
     : size(other.size)
     , squares(other.squares)
+    , row_masks(other.row_masks)
 {
 }
 
@@ -123,6 +192,7 @@ Board& Board::operator=(const Board& other)
     if (this != &other) {
         size = other.size;
         squares = other.squares;
+        row_masks = other.row_masks;
     }
     return *this;
 }
@@ -131,6 +201,7 @@ Board& Board::operator=(const Board& other)
 Board::Board(Board&& other) noexcept
     : size(other.size)
     , squares(std::move(other.squares))
+    , row_masks(std::move(other.row_masks))
 {
 }
 
@@ -140,18 +211,27 @@ Board& Board::operator=(Board&& other) noexcept
     if (this != &other) {
         size = other.size;
         squares = std::move(other.squares);
+        row_masks = std::move(other.row_masks);
     }
     return *this;
 }
 
+bool Board::hasBlocksInBuffer() const
+{
+    for (int y = size.height; y < getGridHeight(); ++y) {
+        if (row_masks[y] != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
 bool Board::canClearLine(int y) const
 {
     if (y < 0 || y >= static_cast<int>(squares.size())) { // Use static_cast for comparison
         return false;
     }
-    // Check only within the logical board width
-    return std::all_of(squares[y].begin(), squares[y].begin() + size.width, // Check only up to size.width
-        [](const Block* block_ptr) { return block_ptr != nullptr; });
+    return isRowFull(y);
 }
 
 int Board::getGridHeight() const
@@ -160,8 +240,8 @@ int Board::getGridHeight() const
 }
 
 // Game Implementation
-Game::Game(GameConfig cfg, Board b, int s, std::vector<const Block*> upcoming)
-    : config(std::move(cfg)) // Use move for config
+Game::Game(std::shared_ptr<const GameConfig> cfg, Board b, int s, std::vector<const Block*> upcoming)
+    : config(std::move(cfg)) // Shared, never copied
     , board(std::move(b)) // Use move for board
     , score(s)
     , upcoming_blocks(std::move(upcoming)) // Use move for upcoming_blocks
@@ -171,7 +251,7 @@ Game::Game(GameConfig cfg, Board b, int s, std::vector<const Block*> upcoming)
 
 // Copy Constructor
 Game::Game(const Game& other)
-    : config(other.config) // GameConfig copy constructor should handle its members
+    : config(other.config) // Shares the config
     , board(other.board) // Board copy constructor should handle its members
     , score(other.score)
     , upcoming_blocks(other.upcoming_blocks) // Copy the vector of pointers
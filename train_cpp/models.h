@@ -1,6 +1,7 @@
 #ifndef MODELS_H
 #define MODELS_H
 
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <optional>
@@ -11,6 +12,9 @@
 // or where the full definition isn't needed in this header.
 class Game;
 class FeatureExtractor;
+struct GameState; // game_state.h
+struct PlacementBatch; // game_state.h
+class TraceWriter; // trace.h
 struct Block; // Forward declare Block for BlockRotation::getOriginalBlock and Game::upcoming_blocks
 
 // --- Basic Structures ---
@@ -60,10 +64,46 @@ struct BlockStatus {
 };
 
 // --- Strategy & AI Related Classes ---
+
+// Feature table for a batch of candidate placements, laid out structure-of-arrays:
+// feature f of candidate i lives at values[f * count + i], so a weight can be applied
+// to one contiguous column across all candidates.
+struct FeatureBatch {
+    int num_features = 0;
+    int count = 0;
+    std::vector<int> values;
+    std::vector<unsigned char> valid; // 0 if the placement is impossible / ends the game
+
+    void resize(int features, int candidates); // Reuses capacity, zero-fills
+    int* column(int feature) { return values.data() + static_cast<size_t>(feature) * count; }
+    const int* column(int feature) const { return values.data() + static_cast<size_t>(feature) * count; }
+};
+
+// Bit f set if feature f contributes to the score (see AssessmentModel::featureMask()).
+// Features at index k_max_masked_features and above are always computed.
+using FeatureMask = std::uint64_t;
+constexpr int k_max_masked_features = 64;
+constexpr FeatureMask k_all_features = ~FeatureMask(0);
+inline bool featureEnabled(FeatureMask mask, int feature)
+{
+    return feature >= k_max_masked_features || ((mask >> feature) & 1);
+}
+
 class FeatureExtractor {
 public:
     virtual ~FeatureExtractor() = default;
     virtual std::vector<int> extractFeatures(const Game& game, const BlockStatus& action) const = 0;
+    // Fills the first num_features columns of `out` for every action in one call.
+    // Columns whose bit is clear in `mask` may be skipped and left 0. If `placements` is
+    // not null it also receives the landing row and post-clear board of every action.
+    // The default implementation loops over extractFeatures(); invalid actions get valid = 0.
+    virtual void extractFeaturesBatch(const Game& game, const std::vector<BlockStatus>& actions, int num_features, FeatureMask mask, FeatureBatch& out, PlacementBatch* placements) const;
+    // Same on a search snapshot. Only valid if supportsGameState(); the default
+    // implementation throws std::logic_error.
+    virtual void extractFeaturesBatch(const GameState& state, const std::vector<BlockStatus>& actions, int num_features, FeatureMask mask, FeatureBatch& out, PlacementBatch* placements) const;
+    // True if the extractor works from row occupancy alone and overrides the GameState
+    // overload; searches keep Game nodes for extractors that don't.
+    virtual bool supportsGameState() const { return false; }
 };
 
 struct AssessmentModel {
@@ -73,6 +113,10 @@ struct AssessmentModel {
 
     AssessmentModel(int len, std::vector<double> w, std::unique_ptr<FeatureExtractor> extractor);
     AssessmentModel(AssessmentModel&&) = default;
+    // Number of features that enter the score: min(length, weights.size())
+    int numFeatures() const;
+    // Features below numFeatures() with a non-zero weight
+    FeatureMask featureMask() const;
     AssessmentModel& operator=(AssessmentModel&&) = default;
     AssessmentModel(const AssessmentModel&) = delete;
     AssessmentModel& operator=(const AssessmentModel&) = delete;
@@ -98,28 +142,50 @@ struct GameConfig {
 
 class Board {
 public:
+    static constexpr int k_buffer_height = 5; // Hidden rows above the logical height
+
     Size size; // Requires full Size definition
     std::vector<std::vector<const Block*>> squares; // Requires forward-declared Block
+    // Occupancy of each grid row, bit x set when squares[y][x] != nullptr.
+    // Kept in sync by setCell() and eliminateLines(); write cells through setCell().
+    std::vector<std::uint32_t> row_masks;
 
+    // Throws std::invalid_argument if width > k_max_board_width or the grid is taller than
+    // k_max_grid_rows (bitboard.h)
     explicit Board(Size s);
     Board(const Board& other);
     Board& operator=(const Board& other);
     Board(Board&& other) noexcept;
     Board& operator=(Board&& other) noexcept;
 
+    void setCell(int x, int y, const Block* block)
+    {
+        squares[y][x] = block;
+        if (block) {
+            row_masks[y] |= std::uint32_t(1) << x;
+        } else {
+            row_masks[y] &= ~(std::uint32_t(1) << x);
+        }
+    }
+    std::uint32_t fullRowMask() const { return size.width >= 32 ? ~std::uint32_t(0) : ((std::uint32_t(1) << size.width) - 1); }
+    bool isRowFull(int y) const { return row_masks[y] == fullRowMask(); }
+    // True if any block sits in the buffer rows above the logical height (game over)
+    bool hasBlocksInBuffer() const;
+
     bool canClearLine(int y) const;
     int getGridHeight() const;
 };
 
 class Game {
 public:
-    GameConfig config; // Requires full GameConfig definition
+    // Immutable and shared by every copy of the game, so copies don't duplicate its vectors
+    std::shared_ptr<const GameConfig> config;
     Board board;       // Requires full Board definition
     int score;
     std::vector<const Block*> upcoming_blocks; // Changed to vector of pointers
     bool game_over;
 
-    Game(GameConfig cfg, Board b, int s, std::vector<const Block*> upcoming); // Updated constructor signature
+    Game(std::shared_ptr<const GameConfig> cfg, Board b, int s, std::vector<const Block*> upcoming); // Updated constructor signature
     Game(const Game& other); // Declare copy constructor
     Game(Game&& other) noexcept; // Declare move constructor
     Game& operator=(const Game& other); // Declare copy assignment operator
@@ -133,6 +199,7 @@ public:
 struct Context {
     Game game;         // Requires full Game definition
     Strategy strategy; // Requires full Strategy definition
+    TraceWriter* trace = nullptr; // Optional move recorder used by runGame (not owned)
 
     Context(Game g, Strategy strat);
     Context(Context&&) = default;
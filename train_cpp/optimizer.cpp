@@ -0,0 +1,349 @@
+#include "optimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+const double k_std_dev_epsilon = 1e-6; // Keeps CEM sigma from collapsing to zero
+const int k_jacobi_max_sweeps = 100;
+
+double calculateMean(const std::vector<double>& v)
+{
+    if (v.empty())
+        return 0.0;
+    return std::accumulate(v.begin(), v.end(), 0.0) / v.size();
+}
+
+// Population standard deviation (divides by N, as numpy does by default)
+double calculateStdDev(const std::vector<double>& v, double mean)
+{
+    if (v.size() < 2)
+        return 0.0;
+    double sq_sum = std::inner_product(v.begin(), v.end(), v.begin(), 0.0,
+        std::plus<>(), [mean](double a, double b) {
+            return (a - mean) * (b - mean);
+        });
+    return std::sqrt(sq_sum / v.size());
+}
+
+// Candidate indices ordered from the highest score to the lowest
+std::vector<int> rankByScore(const std::vector<double>& scores)
+{
+    struct Ranked {
+        int index;
+        double score;
+    };
+    std::vector<Ranked> ranked;
+    ranked.reserve(scores.size());
+    for (size_t i = 0; i < scores.size(); ++i) {
+        ranked.push_back({ static_cast<int>(i), scores[i] });
+    }
+    std::sort(ranked.begin(), ranked.end(), [](const Ranked& a, const Ranked& b) {
+        return a.score > b.score;
+    });
+    std::vector<int> order;
+    order.reserve(ranked.size());
+    for (const Ranked& r : ranked) order.push_back(r.index);
+    return order;
+}
+
+void checkPopulation(const std::vector<std::vector<double>>& population, const std::vector<double>& scores, size_t n)
+{
+    if (population.size() != scores.size()) {
+        throw std::invalid_argument("Optimizer::tell: population and scores differ in size.");
+    }
+    for (const auto& x : population) {
+        if (x.size() != n) throw std::invalid_argument("Optimizer::tell: parameter vector of wrong dimension.");
+    }
+}
+
+} // namespace
+
+// --- CEM ---
+
+CemOptimizer::CemOptimizer(std::vector<double> initial_mean, double initial_std_dev, int population_size, double elite_frac)
+    : mu_(std::move(initial_mean))
+    , sigma_(mu_.size(), initial_std_dev)
+    , population_size_(population_size)
+    , elite_frac_(elite_frac)
+{
+}
+
+std::vector<std::vector<double>> CemOptimizer::ask(std::mt19937& rng) const
+{
+    std::vector<std::vector<double>> sampled(population_size_, std::vector<double>(mu_.size()));
+    for (int i = 0; i < population_size_; ++i) {
+        for (size_t j = 0; j < mu_.size(); ++j) {
+            std::normal_distribution<double> dist(mu_[j], sigma_[j]);
+            sampled[i][j] = dist(rng);
+        }
+    }
+    return sampled;
+}
+
+void CemOptimizer::tell(const std::vector<std::vector<double>>& population, const std::vector<double>& scores)
+{
+    checkPopulation(population, scores, mu_.size());
+    int num_elites = static_cast<int>(population.size() * elite_frac_);
+    if (num_elites == 0 && !population.empty())
+        num_elites = 1;
+    if (num_elites == 0)
+        return; // Nothing to fit: keep the previous distribution
+
+    std::vector<int> order = rankByScore(scores);
+    for (size_t j = 0; j < mu_.size(); ++j) {
+        std::vector<double> values;
+        values.reserve(num_elites);
+        for (int i = 0; i < num_elites; ++i) {
+            values.push_back(population[order[i]][j]);
+        }
+        mu_[j] = calculateMean(values);
+        sigma_[j] = calculateStdDev(values, mu_[j]) + k_std_dev_epsilon;
+    }
+}
+
+// Layout: mu[n], sigma[n]
+std::vector<double> CemOptimizer::serialize() const
+{
+    std::vector<double> state = mu_;
+    state.insert(state.end(), sigma_.begin(), sigma_.end());
+    return state;
+}
+
+void CemOptimizer::deserialize(const std::vector<double>& state)
+{
+    if (state.size() != 2 * mu_.size()) {
+        throw std::runtime_error("CEM state does not match " + std::to_string(mu_.size()) + " parameters.");
+    }
+    mu_.assign(state.begin(), state.begin() + mu_.size());
+    sigma_.assign(state.begin() + mu_.size(), state.end());
+}
+
+// --- CMA-ES ---
+
+CmaEsOptimizer::CmaEsOptimizer(std::vector<double> initial_mean, double initial_step_size, int population_size)
+    : n_(static_cast<int>(initial_mean.size()))
+    , lambda_(population_size > 0 ? population_size : 4 + static_cast<int>(3.0 * std::log(static_cast<double>(initial_mean.size()))))
+    , step_size_(initial_step_size)
+    , mean_(std::move(initial_mean))
+    , pc_(n_, 0.0)
+    , ps_(n_, 0.0)
+    , c_(n_ * n_, 0.0)
+{
+    if (n_ == 0 || lambda_ < 2) {
+        throw std::invalid_argument("CMA-ES needs at least one parameter and a population of 2.");
+    }
+    for (int i = 0; i < n_; ++i) c_[i * n_ + i] = 1.0;
+    setStrategyParameters();
+    updateEigensystem();
+}
+
+// Default recombination weights and learning rates from the tutorial
+void CmaEsOptimizer::setStrategyParameters()
+{
+    const double n = n_;
+    mu_count_ = lambda_ / 2;
+    weights_.resize(mu_count_);
+    for (int i = 0; i < mu_count_; ++i) {
+        weights_[i] = std::log((lambda_ + 1) / 2.0) - std::log(i + 1.0);
+    }
+    double sum = std::accumulate(weights_.begin(), weights_.end(), 0.0);
+    double sum_sq = 0.0;
+    for (double& w : weights_) {
+        w /= sum;
+        sum_sq += w * w;
+    }
+    mueff_ = 1.0 / sum_sq;
+
+    cc_ = (4.0 + mueff_ / n) / (n + 4.0 + 2.0 * mueff_ / n);
+    cs_ = (mueff_ + 2.0) / (n + mueff_ + 5.0);
+    c1_ = 2.0 / ((n + 1.3) * (n + 1.3) + mueff_);
+    cmu_ = std::min(1.0 - c1_, 2.0 * (mueff_ - 2.0 + 1.0 / mueff_) / ((n + 2.0) * (n + 2.0) + mueff_));
+    damps_ = 1.0 + 2.0 * std::max(0.0, std::sqrt((mueff_ - 1.0) / (n + 1.0)) - 1.0) + cs_;
+    chi_n_ = std::sqrt(n) * (1.0 - 1.0 / (4.0 * n) + 1.0 / (21.0 * n * n));
+}
+
+void CmaEsOptimizer::updateEigensystem()
+{
+    std::vector<double> eigenvalues;
+    symmetricEigen(n_, c_, eigenvalues, b_);
+    d_.resize(n_);
+    for (int i = 0; i < n_; ++i) {
+        d_[i] = std::sqrt(std::max(eigenvalues[i], 1e-20)); // Rounding can push tiny eigenvalues below zero
+    }
+}
+
+std::vector<std::vector<double>> CmaEsOptimizer::ask(std::mt19937& rng) const
+{
+    std::normal_distribution<double> standard(0.0, 1.0);
+    std::vector<std::vector<double>> sampled(lambda_, std::vector<double>(n_));
+    std::vector<double> scaled(n_);
+    for (int k = 0; k < lambda_; ++k) {
+        for (int j = 0; j < n_; ++j) scaled[j] = d_[j] * standard(rng);
+        for (int i = 0; i < n_; ++i) {
+            double y = 0.0;
+            for (int j = 0; j < n_; ++j) y += b_[i * n_ + j] * scaled[j];
+            sampled[k][i] = mean_[i] + step_size_ * y; // x = m + sigma * B D z
+        }
+    }
+    return sampled;
+}
+
+void CmaEsOptimizer::tell(const std::vector<std::vector<double>>& population, const std::vector<double>& scores)
+{
+    checkPopulation(population, scores, n_);
+    if (static_cast<int>(population.size()) < mu_count_) {
+        throw std::invalid_argument("CMA-ES tell: population smaller than the number of parents.");
+    }
+    std::vector<int> order = rankByScore(scores); // Best first: we maximize the score
+
+    // Steps of the selected parents, in units of the step size
+    std::vector<std::vector<double>> steps(mu_count_, std::vector<double>(n_));
+    std::vector<double> mean_step(n_, 0.0);
+    for (int k = 0; k < mu_count_; ++k) {
+        const std::vector<double>& x = population[order[k]];
+        for (int i = 0; i < n_; ++i) {
+            steps[k][i] = (x[i] - mean_[i]) / step_size_;
+            mean_step[i] += weights_[k] * steps[k][i];
+        }
+    }
+    for (int i = 0; i < n_; ++i) mean_[i] += step_size_ * mean_step[i];
+
+    // C^(-1/2) * mean_step = B D^-1 B^T mean_step
+    std::vector<double> rotated(n_, 0.0), whitened(n_, 0.0);
+    for (int j = 0; j < n_; ++j) {
+        for (int i = 0; i < n_; ++i) rotated[j] += b_[i * n_ + j] * mean_step[i];
+        rotated[j] /= d_[j];
+    }
+    for (int i = 0; i < n_; ++i) {
+        for (int j = 0; j < n_; ++j) whitened[i] += b_[i * n_ + j] * rotated[j];
+    }
+
+    // Evolution paths
+    const double cs_norm = std::sqrt(cs_ * (2.0 - cs_) * mueff_);
+    double ps_sq = 0.0;
+    for (int i = 0; i < n_; ++i) {
+        ps_[i] = (1.0 - cs_) * ps_[i] + cs_norm * whitened[i];
+        ps_sq += ps_[i] * ps_[i];
+    }
+    const double ps_norm = std::sqrt(ps_sq);
+    generation_++;
+    const bool hsig = ps_norm / std::sqrt(1.0 - std::pow(1.0 - cs_, 2.0 * generation_)) / chi_n_ < 1.4 + 2.0 / (n_ + 1.0);
+    const double cc_norm = std::sqrt(cc_ * (2.0 - cc_) * mueff_);
+    for (int i = 0; i < n_; ++i) {
+        pc_[i] = (1.0 - cc_) * pc_[i] + (hsig ? cc_norm * mean_step[i] : 0.0);
+    }
+
+    // Covariance: decay + rank-one (pc) + rank-mu (parent steps)
+    const double stall = hsig ? 0.0 : cc_ * (2.0 - cc_); // Compensates the suppressed pc update
+    for (int i = 0; i < n_; ++i) {
+        for (int j = 0; j <= i; ++j) {
+            double rank_mu = 0.0;
+            for (int k = 0; k < mu_count_; ++k) rank_mu += weights_[k] * steps[k][i] * steps[k][j];
+            double value = (1.0 - c1_ - cmu_) * c_[i * n_ + j]
+                + c1_ * (pc_[i] * pc_[j] + stall * c_[i * n_ + j])
+                + cmu_ * rank_mu;
+            c_[i * n_ + j] = value;
+            c_[j * n_ + i] = value;
+        }
+    }
+
+    step_size_ *= std::exp((cs_ / damps_) * (ps_norm / chi_n_ - 1.0));
+    updateEigensystem();
+}
+
+std::vector<double> CmaEsOptimizer::stdDevs() const
+{
+    std::vector<double> result(n_);
+    for (int i = 0; i < n_; ++i) result[i] = step_size_ * std::sqrt(c_[i * n_ + i]);
+    return result;
+}
+
+// Layout: n, lambda, generation, step size, mean[n], pc[n], ps[n], C[n*n]
+std::vector<double> CmaEsOptimizer::serialize() const
+{
+    std::vector<double> state = { static_cast<double>(n_), static_cast<double>(lambda_),
+        static_cast<double>(generation_), step_size_ };
+    state.insert(state.end(), mean_.begin(), mean_.end());
+    state.insert(state.end(), pc_.begin(), pc_.end());
+    state.insert(state.end(), ps_.begin(), ps_.end());
+    state.insert(state.end(), c_.begin(), c_.end());
+    return state;
+}
+
+void CmaEsOptimizer::deserialize(const std::vector<double>& state)
+{
+    const size_t n = n_;
+    if (state.size() != 4 + 3 * n + n * n || state[0] != n_) {
+        throw std::runtime_error("CMA-ES state does not match " + std::to_string(n_) + " parameters.");
+    }
+    lambda_ = static_cast<int>(state[1]);
+    generation_ = static_cast<int>(state[2]);
+    step_size_ = state[3];
+    auto it = state.begin() + 4;
+    mean_.assign(it, it + n);
+    pc_.assign(it + n, it + 2 * n);
+    ps_.assign(it + 2 * n, it + 3 * n);
+    c_.assign(it + 3 * n, state.end());
+    setStrategyParameters();
+    updateEigensystem();
+}
+
+std::unique_ptr<Optimizer> makeOptimizer(const std::string& name, const std::vector<double>& initial_mean,
+    double initial_std_dev, int population_size, double elite_frac)
+{
+    if (name == "cem") {
+        return std::make_unique<CemOptimizer>(initial_mean, initial_std_dev, population_size, elite_frac);
+    }
+    if (name == "cma_es") {
+        return std::make_unique<CmaEsOptimizer>(initial_mean, initial_std_dev, population_size);
+    }
+    throw std::invalid_argument("Unknown optimizer '" + name + "' (expected cem or cma_es).");
+}
+
+void symmetricEigen(int n, std::vector<double> a, std::vector<double>& eigenvalues, std::vector<double>& eigenvectors)
+{
+    eigenvectors.assign(n * n, 0.0);
+    for (int i = 0; i < n; ++i) eigenvectors[i * n + i] = 1.0;
+
+    for (int sweep = 0; sweep < k_jacobi_max_sweeps; ++sweep) {
+        double off = 0.0, diag = 0.0;
+        for (int i = 0; i < n; ++i) {
+            diag += a[i * n + i] * a[i * n + i];
+            for (int j = i + 1; j < n; ++j) off += a[i * n + j] * a[i * n + j];
+        }
+        if (off <= 1e-30 * diag || off == 0.0) break;
+
+        for (int p = 0; p < n; ++p) {
+            for (int q = p + 1; q < n; ++q) {
+                double apq = a[p * n + q];
+                if (apq == 0.0) continue;
+                // Rotation angle that zeroes a[p][q]
+                double theta = (a[q * n + q] - a[p * n + p]) / (2.0 * apq);
+                double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::fabs(theta) + std::sqrt(theta * theta + 1.0));
+                double c = 1.0 / std::sqrt(t * t + 1.0);
+                double s = t * c;
+                for (int k = 0; k < n; ++k) {
+                    double akp = a[k * n + p], akq = a[k * n + q];
+                    a[k * n + p] = c * akp - s * akq;
+                    a[k * n + q] = s * akp + c * akq;
+                }
+                for (int k = 0; k < n; ++k) {
+                    double apk = a[p * n + k], aqk = a[q * n + k];
+                    a[p * n + k] = c * apk - s * aqk;
+                    a[q * n + k] = s * apk + c * aqk;
+                }
+                for (int k = 0; k < n; ++k) {
+                    double vkp = eigenvectors[k * n + p], vkq = eigenvectors[k * n + q];
+                    eigenvectors[k * n + p] = c * vkp - s * vkq;
+                    eigenvectors[k * n + q] = s * vkp + c * vkq;
+                }
+            }
+        }
+    }
+    eigenvalues.resize(n);
+    for (int i = 0; i < n; ++i) eigenvalues[i] = a[i * n + i];
+}
@@ -0,0 +1,100 @@
+#ifndef OPTIMIZER_H
+#define OPTIMIZER_H
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Black-box optimizer driven by runTraining(): ask() samples a population, the caller
+// evaluates it (higher score is better) and tell() updates the search distribution.
+// The whole distribution round-trips through serialize()/deserialize() so it can be
+// stored in a TrainingState checkpoint.
+class Optimizer {
+public:
+    virtual ~Optimizer() = default;
+
+    virtual std::string name() const = 0;
+    virtual int populationSize() const = 0;
+
+    // Draws populationSize() parameter vectors from the current distribution
+    virtual std::vector<std::vector<double>> ask(std::mt19937& rng) const = 0;
+    // Updates the distribution from a population returned by ask() and its scores
+    virtual void tell(const std::vector<std::vector<double>>& population, const std::vector<double>& scores) = 0;
+
+    virtual std::vector<double> mean() const = 0;
+    virtual std::vector<double> stdDevs() const = 0; // Marginal standard deviation per parameter
+
+    virtual std::vector<double> serialize() const = 0;
+    // Throws std::runtime_error if `state` was not produced by this optimizer and dimension
+    virtual void deserialize(const std::vector<double>& state) = 0;
+};
+
+// Diagonal cross-entropy method: independent Gaussian per parameter, refitted to the
+// top `elite_frac` of each population.
+class CemOptimizer : public Optimizer {
+public:
+    CemOptimizer(std::vector<double> initial_mean, double initial_std_dev, int population_size, double elite_frac);
+
+    std::string name() const override { return "cem"; }
+    int populationSize() const override { return population_size_; }
+    std::vector<std::vector<double>> ask(std::mt19937& rng) const override;
+    void tell(const std::vector<std::vector<double>>& population, const std::vector<double>& scores) override;
+    std::vector<double> mean() const override { return mu_; }
+    std::vector<double> stdDevs() const override { return sigma_; }
+    std::vector<double> serialize() const override;
+    void deserialize(const std::vector<double>& state) override;
+
+private:
+    std::vector<double> mu_;
+    std::vector<double> sigma_;
+    int population_size_;
+    double elite_frac_;
+};
+
+// CMA-ES with rank-one and rank-mu covariance updates and cumulative step-size adaptation
+// (Hansen, "The CMA Evolution Strategy: A Tutorial"). Adapts a full covariance matrix, so
+// correlated weights are searched along their joint directions.
+class CmaEsOptimizer : public Optimizer {
+public:
+    // population_size <= 0 selects the default 4 + floor(3 ln n)
+    CmaEsOptimizer(std::vector<double> initial_mean, double initial_step_size, int population_size = 0);
+
+    std::string name() const override { return "cma_es"; }
+    int populationSize() const override { return lambda_; }
+    std::vector<std::vector<double>> ask(std::mt19937& rng) const override;
+    void tell(const std::vector<std::vector<double>>& population, const std::vector<double>& scores) override;
+    std::vector<double> mean() const override { return mean_; }
+    std::vector<double> stdDevs() const override;
+    std::vector<double> serialize() const override;
+    void deserialize(const std::vector<double>& state) override;
+
+private:
+    void setStrategyParameters();
+    void updateEigensystem();
+
+    int n_;
+    int lambda_;
+    int mu_count_;
+    std::vector<double> weights_;
+    double mueff_, cc_, cs_, c1_, cmu_, damps_, chi_n_;
+
+    int generation_ = 0;
+    double step_size_;
+    std::vector<double> mean_;
+    std::vector<double> pc_, ps_;
+    std::vector<double> c_; // Covariance, row-major n x n
+    std::vector<double> b_; // Eigenvectors of C (columns), row-major n x n
+    std::vector<double> d_; // Square roots of the eigenvalues of C
+};
+
+// Creates the optimizer selected by `name` ("cem" or "cma_es");
+// throws std::invalid_argument for an unknown name
+std::unique_ptr<Optimizer> makeOptimizer(const std::string& name, const std::vector<double>& initial_mean,
+    double initial_std_dev, int population_size, double elite_frac);
+
+// Eigen-decomposition of the symmetric n x n row-major matrix `a` by cyclic Jacobi rotations.
+// On return `eigenvalues` holds the eigenvalues and column k of `eigenvectors` the k-th eigenvector.
+void symmetricEigen(int n, std::vector<double> a, std::vector<double>& eigenvalues, std::vector<double>& eigenvectors);
+
+#endif // OPTIMIZER_H
@@ -0,0 +1,176 @@
+// tetris_replay: inspects a trace written by tetris_test -t / runGame, jumps to any move
+// through the nearest checkpoint and optionally re-runs the recorded model from there.
+//
+//   tetris_replay <trace> [--seek N] [--verify] [--show]
+//     --seek N   restore the last checkpoint before move N and apply the recorded moves up to N
+//     --verify   from there on, re-decide every move with the model stored in the trace and
+//                report the first move where the decision differs from the recording
+//     --show     print the board at the reached position
+
+#include "constants.h"
+#include "extractor.h"
+#include "game.h"
+#include "models.h"
+#include "trace.h"
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+void printBoard(const Board& board)
+{
+    for (int y = board.getGridHeight() - 1; y >= 0; --y) {
+        std::cout << (y >= board.size.height ? "  ^ |" : "    |");
+        for (int x = 0; x < board.size.width; ++x) {
+            std::cout << (board.squares[y][x] ? board.squares[y][x]->label : std::string("."));
+        }
+        std::cout << "|\n";
+    }
+}
+
+// Preview after move `index`: the pieces of the next two recorded moves
+void setRecordedPreview(Game& game, const TraceReader& reader, std::uint64_t index)
+{
+    game.upcoming_blocks.clear();
+    for (std::uint64_t next = index + 1; next <= index + 2 && next < reader.moveCount(); ++next) {
+        game.upcoming_blocks.push_back(k_blocks[reader.move(next).piece]);
+    }
+}
+
+// Applies recorded move `index`; returns false if it ends the game
+bool applyRecordedMove(Game& game, const TraceReader& reader, std::uint64_t index)
+{
+    TraceMove move = reader.move(index);
+    if (game.upcoming_blocks.empty() || game.upcoming_blocks[0] != k_blocks[move.piece]) {
+        throw std::runtime_error("Recorded piece does not match the game preview at move " + std::to_string(index));
+    }
+    if (game.upcoming_blocks.size() < 2) {
+        game.upcoming_blocks.push_back(game.upcoming_blocks[0]); // Past the recording; replaced below
+    }
+    try {
+        executeAction(game, traceMoveAction(move));
+    } catch (const std::runtime_error&) {
+        return false; // Placement overflowed: this is how the recorded game ended
+    }
+    setRecordedPreview(game, reader, index);
+    return !game.isEnd();
+}
+
+bool sameBoard(const Game& game, const TraceCheckpoint& checkpoint)
+{
+    size_t cell = 0;
+    for (int y = 0; y < game.board.getGridHeight(); ++y) {
+        for (int x = 0; x < game.board.size.width; ++x) {
+            int piece = checkpoint.cells[cell++] - 1;
+            const Block* expected = piece >= 0 ? k_blocks[piece] : nullptr;
+            if (game.board.squares[y][x] != expected) return false;
+        }
+    }
+    return game.score == checkpoint.score;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " <trace> [--seek N] [--verify] [--show]" << std::endl;
+        return 2;
+    }
+    std::string path = argv[1];
+    std::uint64_t seek = 0;
+    bool verify = false;
+    bool show = false;
+    for (int i = 2; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--seek" && i + 1 < argc) {
+            seek = std::stoull(argv[++i]);
+        } else if (arg == "--verify") {
+            verify = true;
+        } else if (arg == "--show") {
+            show = true;
+        } else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return 2;
+        }
+    }
+
+    try {
+        TraceReader reader(path);
+        std::cout << "Trace " << path << ": " << reader.width() << "x" << reader.height() << " board, "
+                  << reader.moveCount() << " moves, " << reader.checkpointCount() << " checkpoints (every "
+                  << reader.checkpointInterval() << " moves), ";
+        if (reader.finished()) {
+            std::cout << "final score " << reader.finalScore() << std::endl;
+        } else {
+            std::cout << "no end record (run did not finish)" << std::endl;
+        }
+        if (seek > reader.moveCount()) {
+            seek = reader.moveCount();
+        }
+
+        // --- Seek: nearest checkpoint, then the recorded moves up to `seek` ---
+        auto start = std::chrono::steady_clock::now();
+        size_t checkpoint_index = reader.checkpointBefore(seek);
+        TraceCheckpoint checkpoint = reader.loadCheckpoint(checkpoint_index);
+        Game game = restoreCheckpoint(reader, checkpoint);
+        std::uint64_t move = checkpoint.move_index;
+        bool alive = true;
+        for (; move < seek && alive; ++move) {
+            alive = applyRecordedMove(game, reader, move);
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+        std::cout << "At move " << move << " (checkpoint " << checkpoint.move_index << " + "
+                  << move - checkpoint.move_index << " moves, " << elapsed.count() << " ms): score "
+                  << game.score << (alive ? "" : ", game over") << std::endl;
+
+        if (verify && alive) {
+            // --- Re-run the stored model from here and compare with the recording ---
+            auto model = std::make_unique<AssessmentModel>(reader.modelLength(), reader.weights(),
+                std::make_unique<MyDbtFeatureExtractorCpp>());
+            std::uint64_t mismatches = 0;
+            size_t next_checkpoint = checkpoint_index + 1;
+            for (; move < reader.moveCount() && alive; ++move) {
+                if (next_checkpoint < reader.checkpointCount() && reader.checkpointMove(next_checkpoint) == move) {
+                    if (!sameBoard(game, reader.loadCheckpoint(next_checkpoint))) {
+                        std::cout << "Board differs from the checkpoint at move " << move << std::endl;
+                        return 1;
+                    }
+                    next_checkpoint++;
+                }
+                TraceMove recorded = reader.move(move);
+                std::vector<BlockStatus> actions = getAllActions(*k_blocks[recorded.piece], game.board.size.width);
+                BlockStatus decided = findBestAction(game, actions, *model);
+                BlockStatus expected = traceMoveAction(recorded);
+                if (decided.rotation != expected.rotation || decided.x_offset != expected.x_offset) {
+                    if (mismatches == 0) {
+                        std::cout << "First differing decision at move " << move << ": recorded x="
+                                  << expected.x_offset << " " << expected.rotation->label << ", model x="
+                                  << decided.x_offset << " " << decided.rotation->label << std::endl;
+                    }
+                    mismatches++;
+                }
+                alive = applyRecordedMove(game, reader, move);
+            }
+            std::cout << "Verified up to move " << move << ": " << mismatches << " differing decisions, score "
+                      << game.score;
+            if (reader.finished() && move == reader.moveCount()) {
+                std::cout << (game.score == reader.finalScore() ? " (matches the recording)" : " (recording differs)");
+            }
+            std::cout << std::endl;
+            if (mismatches != 0) return 1;
+        }
+
+        if (show) {
+            printBoard(game.board);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Error: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,43 @@
+#include "search_pool.h"
+#include "game.h" // getAllActions
+
+SearchScratchPool& SearchScratchPool::local()
+{
+    static thread_local SearchScratchPool pool;
+    return pool;
+}
+
+const std::vector<BlockStatus>& SearchScratchPool::actionsFor(const Block& block, int board_width)
+{
+    for (const auto& table : action_tables_) {
+        if (table.block == &block && table.board_width == board_width) {
+            return table.actions;
+        }
+    }
+    action_tables_.push_back({ &block, board_width, getAllActions(block, board_width) });
+    return action_tables_.back().actions;
+}
+
+FeatureBatch& SearchScratchPool::plyBatch(int depth)
+{
+    if (depth >= static_cast<int>(ply_batches_.size())) {
+        ply_batches_.resize(depth + 1);
+    }
+    return ply_batches_[depth];
+}
+
+std::vector<double>& SearchScratchPool::plyScores(int depth)
+{
+    if (depth >= static_cast<int>(ply_scores_.size())) {
+        ply_scores_.resize(depth + 1);
+    }
+    return ply_scores_[depth];
+}
+
+PlacementBatch& SearchScratchPool::plyPlacements(int depth)
+{
+    if (depth >= static_cast<int>(ply_placements_.size())) {
+        ply_placements_.resize(depth + 1);
+    }
+    return ply_placements_[depth];
+}
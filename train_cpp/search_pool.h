@@ -0,0 +1,41 @@
+#ifndef SEARCH_POOL_H
+#define SEARCH_POOL_H
+
+#include "game_state.h"
+#include "models.h"
+#include <deque>
+#include <vector>
+
+// Per-thread scratch for multi-ply search (findBestActionV2 and deeper searches).
+// Search nodes themselves are trivially copyable GameState values (game_state.h); the pool
+// keeps what a node would otherwise allocate: the action tables of each piece and the
+// feature / score buffers of each ply. After warm-up a search node does no heap allocation.
+class SearchScratchPool {
+public:
+    // The calling thread's pool
+    static SearchScratchPool& local();
+
+    // getAllActions(block, board_width), built once per thread and reused. The table keeps
+    // pointers into `block`, which must outlive the pool (the k_blocks entries do).
+    const std::vector<BlockStatus>& actionsFor(const Block& block, int board_width);
+
+    // Feature / score / placement buffers for evaluating a whole ply with evaluatePlacements()
+    FeatureBatch& plyBatch(int depth);
+    std::vector<double>& plyScores(int depth);
+    PlacementBatch& plyPlacements(int depth);
+
+private:
+    struct ActionTable {
+        const Block* block;
+        int board_width;
+        std::vector<BlockStatus> actions;
+    };
+
+    // deques: growing them keeps the references handed out earlier valid
+    std::deque<ActionTable> action_tables_;
+    std::deque<FeatureBatch> ply_batches_;
+    std::deque<std::vector<double>> ply_scores_;
+    std::deque<PlacementBatch> ply_placements_;
+};
+
+#endif // SEARCH_POOL_H
@@ -0,0 +1,359 @@
+#include "trace.h"
+#include "constants.h"
+#include "extractor.h" // getBlockFromRotation
+#include "game.h"      // createNewGame
+#include <cstring>
+#include <stdexcept>
+#include <type_traits>
+
+namespace {
+
+constexpr char k_trace_magic[4] = { 'T', 'T', 'R', 'C' };
+constexpr char k_tag_checkpoint = 'C';
+constexpr char k_tag_moves = 'M';
+constexpr char k_tag_end = 'E';
+constexpr size_t k_write_buffer_size = 1 << 16;
+constexpr std::uint32_t k_max_moves_per_record = 0xffff;
+
+// Unsigned integer with the size of T, to move an arithmetic value's bits around
+template <size_t Size> struct UnsignedOfSize;
+template <> struct UnsignedOfSize<1> { using type = std::uint8_t; };
+template <> struct UnsignedOfSize<2> { using type = std::uint16_t; };
+template <> struct UnsignedOfSize<4> { using type = std::uint32_t; };
+template <> struct UnsignedOfSize<8> { using type = std::uint64_t; };
+
+template <class T>
+void storeLittleEndian(T value, unsigned char* out)
+{
+    static_assert(std::is_arithmetic<T>::value, "Trace fields are integers or doubles");
+    typename UnsignedOfSize<sizeof(T)>::type bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    for (size_t i = 0; i < sizeof(T); ++i) out[i] = static_cast<unsigned char>(bits >> (8 * i));
+}
+
+template <class T>
+T loadLittleEndian(const unsigned char* in)
+{
+    static_assert(std::is_arithmetic<T>::value, "Trace fields are integers or doubles");
+    typename UnsignedOfSize<sizeof(T)>::type bits = 0;
+    for (size_t i = 0; i < sizeof(T); ++i) bits |= static_cast<decltype(bits)>(static_cast<decltype(bits)>(in[i]) << (8 * i));
+    T value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+template <class T>
+bool readValue(std::istream& in, T& value)
+{
+    unsigned char bytes[sizeof(T)];
+    if (!in.read(reinterpret_cast<char*>(bytes), sizeof(bytes))) return false;
+    value = loadLittleEndian<T>(bytes);
+    return true;
+}
+
+std::uint8_t pieceByte(const Block* block)
+{
+    return static_cast<std::uint8_t>(block ? traceBlockIndex(block) + 1 : 0);
+}
+
+} // namespace
+
+std::uint16_t encodeTraceMove(const TraceMove& move)
+{
+    if (move.piece < 0 || move.piece > 7 || move.rotation < 0 || move.rotation > 3 || move.x < 0 || move.x > 63) {
+        throw std::invalid_argument("Move does not fit the trace encoding.");
+    }
+    return static_cast<std::uint16_t>(move.piece | (move.rotation << 3) | (move.x << 5));
+}
+
+TraceMove decodeTraceMove(std::uint16_t packed)
+{
+    TraceMove move;
+    move.piece = packed & 0x7;
+    move.rotation = (packed >> 3) & 0x3;
+    move.x = (packed >> 5) & 0x3f;
+    return move;
+}
+
+int traceBlockIndex(const Block* block)
+{
+    for (size_t i = 0; i < k_blocks.size(); ++i) {
+        if (k_blocks[i] == block) return static_cast<int>(i);
+    }
+    return -1;
+}
+
+// --- TraceWriter ---
+
+TraceWriter::TraceWriter(const std::string& path, const Game& game, const AssessmentModel& model, std::uint32_t checkpoint_interval)
+    : file_(path, std::ios::binary | std::ios::trunc)
+    , checkpoint_interval_(checkpoint_interval)
+{
+    if (!file_) {
+        throw std::runtime_error("Cannot open trace file for writing: " + path);
+    }
+    if (checkpoint_interval_ == 0 || checkpoint_interval_ > k_max_moves_per_record) {
+        throw std::invalid_argument("Trace checkpoint interval must be in [1, 65535].");
+    }
+    buffer_.reserve(k_write_buffer_size);
+    pending_moves_.reserve(checkpoint_interval_);
+
+    put(k_trace_magic, sizeof(k_trace_magic));
+    putValue<std::uint16_t>(k_trace_version);
+    putValue<std::uint16_t>(static_cast<std::uint16_t>(game.board.size.width));
+    putValue<std::uint16_t>(static_cast<std::uint16_t>(game.board.size.height));
+    putValue<std::uint16_t>(static_cast<std::uint16_t>(game.board.getGridHeight() - game.board.size.height));
+    putValue<std::uint32_t>(checkpoint_interval_);
+    putValue<std::uint32_t>(static_cast<std::uint32_t>(model.length));
+    putValue<std::uint32_t>(static_cast<std::uint32_t>(model.weights.size()));
+    for (double w : model.weights) {
+        putValue<double>(w);
+    }
+}
+
+TraceWriter::~TraceWriter()
+{
+    // Without finish() the trace has no end record, like a crashed run
+    try {
+        flushMoves();
+        flushBuffer();
+    } catch (...) {
+    }
+}
+
+void TraceWriter::recordMove(const Game& game, const BlockStatus& action)
+{
+    if (finished_) return;
+    if (moves_ % checkpoint_interval_ == 0) {
+        writeCheckpoint(game);
+    }
+    const Block* block = getBlockFromRotation(action.rotation);
+    if (!block) {
+        throw std::runtime_error("Trace: action rotation does not belong to k_blocks.");
+    }
+    TraceMove move;
+    move.piece = traceBlockIndex(block);
+    move.rotation = static_cast<int>(action.rotation - block->rotations.data());
+    move.x = action.x_offset;
+    pending_moves_.push_back(encodeTraceMove(move));
+    moves_++;
+}
+
+void TraceWriter::finish(const Game& game)
+{
+    if (finished_) return;
+    flushMoves();
+    putValue<char>(k_tag_end);
+    putValue<std::uint64_t>(moves_);
+    putValue<std::int32_t>(game.score);
+    flushBuffer();
+    file_.flush();
+    finished_ = true;
+}
+
+void TraceWriter::writeCheckpoint(const Game& game)
+{
+    flushMoves();
+    putValue<char>(k_tag_checkpoint);
+    putValue<std::uint64_t>(moves_);
+    putValue<std::int32_t>(game.score);
+    for (int i = 0; i < 2; ++i) {
+        const Block* block = i < static_cast<int>(game.upcoming_blocks.size()) ? game.upcoming_blocks[i] : nullptr;
+        putValue<std::uint8_t>(pieceByte(block));
+    }
+    const Board& board = game.board;
+    for (int y = 0; y < board.getGridHeight(); ++y) {
+        for (int x = 0; x < board.size.width; ++x) {
+            putValue<std::uint8_t>(pieceByte(board.squares[y][x]));
+        }
+    }
+    // A checkpoint is where a crashed run can be resumed from, so hand it to the OS now
+    flushBuffer();
+    file_.flush();
+}
+
+void TraceWriter::flushMoves()
+{
+    if (pending_moves_.empty()) return;
+    putValue<char>(k_tag_moves);
+    putValue<std::uint16_t>(static_cast<std::uint16_t>(pending_moves_.size()));
+    for (std::uint16_t move : pending_moves_) {
+        putValue<std::uint16_t>(move);
+    }
+    pending_moves_.clear();
+}
+
+template <class T>
+void TraceWriter::putValue(T value)
+{
+    unsigned char bytes[sizeof(T)];
+    storeLittleEndian(value, bytes);
+    put(bytes, sizeof(bytes));
+}
+
+void TraceWriter::put(const void* data, size_t size)
+{
+    if (buffer_.size() + size > k_write_buffer_size) {
+        flushBuffer();
+    }
+    const char* bytes = static_cast<const char*>(data);
+    buffer_.insert(buffer_.end(), bytes, bytes + size);
+}
+
+void TraceWriter::flushBuffer()
+{
+    if (buffer_.empty()) return;
+    file_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    buffer_.clear();
+    if (!file_) {
+        throw std::runtime_error("Failed to write trace file.");
+    }
+}
+
+// --- TraceReader ---
+
+TraceReader::TraceReader(const std::string& path)
+    : path_(path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        throw std::runtime_error("Cannot open trace file: " + path);
+    }
+    in.seekg(0, std::ios::end);
+    const std::streamoff file_size = in.tellg();
+    in.seekg(0);
+    char magic[4];
+    std::uint16_t version, width, height, buffer_height;
+    std::uint32_t model_length, num_weights;
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, k_trace_magic, sizeof(magic)) != 0) {
+        throw std::runtime_error("Not a trace file: " + path);
+    }
+    if (!readValue(in, version) || version != k_trace_version) {
+        throw std::runtime_error("Unsupported trace version in " + path);
+    }
+    if (!readValue(in, width) || !readValue(in, height) || !readValue(in, buffer_height)
+        || !readValue(in, checkpoint_interval_) || !readValue(in, model_length) || !readValue(in, num_weights)) {
+        throw std::runtime_error("Truncated trace header in " + path);
+    }
+    width_ = width;
+    height_ = height;
+    buffer_height_ = buffer_height;
+    model_length_ = static_cast<int>(model_length);
+    weights_.resize(num_weights);
+    for (auto& w : weights_) {
+        if (!readValue(in, w)) {
+            throw std::runtime_error("Truncated trace header in " + path);
+        }
+    }
+
+    const std::streamoff cells_size = static_cast<std::streamoff>(width_) * (height_ + buffer_height_);
+    char tag;
+    while (readValue(in, tag)) {
+        if (tag == k_tag_checkpoint) {
+            std::uint64_t move_index;
+            std::streamoff payload = in.tellg();
+            std::streamoff payload_end = payload + static_cast<std::streamoff>(sizeof(move_index) + sizeof(std::int32_t) + 2) + cells_size;
+            if (payload_end > file_size || !readValue(in, move_index) || move_index != moves_.size()) break;
+            in.seekg(payload_end);
+            checkpoint_offsets_.push_back(static_cast<std::uint64_t>(payload));
+            checkpoint_moves_.push_back(move_index);
+        } else if (tag == k_tag_moves) {
+            std::uint16_t count;
+            if (!readValue(in, count)) break;
+            std::vector<unsigned char> bytes(count * sizeof(std::uint16_t));
+            if (!in.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()))) {
+                break; // Cut off mid-record
+            }
+            for (size_t i = 0; i < count; ++i) {
+                moves_.push_back(loadLittleEndian<std::uint16_t>(&bytes[i * sizeof(std::uint16_t)]));
+            }
+        } else if (tag == k_tag_end) {
+            std::uint64_t total_moves;
+            std::int32_t score;
+            if (readValue(in, total_moves) && readValue(in, score) && total_moves == moves_.size()) {
+                finished_ = true;
+                final_score_ = score;
+            }
+            break;
+        } else {
+            throw std::runtime_error("Corrupt trace record in " + path);
+        }
+    }
+    if (checkpoint_offsets_.empty()) {
+        throw std::runtime_error("Trace has no checkpoint: " + path);
+    }
+}
+
+TraceMove TraceReader::move(std::uint64_t index) const
+{
+    TraceMove move = decodeTraceMove(moves_[index]);
+    if (move.piece >= static_cast<int>(k_blocks.size())
+        || move.rotation >= static_cast<int>(k_blocks[move.piece]->rotations.size())) {
+        throw std::runtime_error("Trace move " + std::to_string(index) + " refers to an unknown piece or rotation.");
+    }
+    return move;
+}
+
+size_t TraceReader::checkpointBefore(std::uint64_t move_index) const
+{
+    size_t index = 0;
+    while (index + 1 < checkpoint_moves_.size() && checkpoint_moves_[index + 1] <= move_index) {
+        index++;
+    }
+    return index;
+}
+
+TraceCheckpoint TraceReader::loadCheckpoint(size_t index) const
+{
+    std::ifstream in(path_, std::ios::binary);
+    in.seekg(static_cast<std::streamoff>(checkpoint_offsets_.at(index)));
+    TraceCheckpoint checkpoint;
+    std::int32_t score;
+    std::uint8_t preview[2];
+    checkpoint.cells.resize(static_cast<size_t>(width_) * (height_ + buffer_height_));
+    if (!readValue(in, checkpoint.move_index) || !readValue(in, score) || !in.read(reinterpret_cast<char*>(preview), 2)
+        || !in.read(reinterpret_cast<char*>(checkpoint.cells.data()), static_cast<std::streamsize>(checkpoint.cells.size()))) {
+        throw std::runtime_error("Failed to read trace checkpoint.");
+    }
+    checkpoint.score = score;
+    checkpoint.preview[0] = preview[0] - 1;
+    checkpoint.preview[1] = preview[1] - 1;
+    return checkpoint;
+}
+
+Game restoreCheckpoint(const TraceReader& reader, const TraceCheckpoint& checkpoint)
+{
+    Game game = createNewGame();
+    if (game.board.size.width != reader.width() || game.board.size.height != reader.height()
+        || game.board.getGridHeight() != reader.height() + reader.bufferHeight()) {
+        throw std::runtime_error("Trace board size does not match createNewGame().");
+    }
+    auto blockAt = [](int piece) -> const Block* {
+        if (piece < 0) return nullptr;
+        if (piece >= static_cast<int>(k_blocks.size())) {
+            throw std::runtime_error("Trace refers to an unknown piece.");
+        }
+        return k_blocks[piece];
+    };
+    size_t cell = 0;
+    for (int y = 0; y < game.board.getGridHeight(); ++y) {
+        for (int x = 0; x < game.board.size.width; ++x) {
+            game.board.setCell(x, y, blockAt(checkpoint.cells[cell++] - 1));
+        }
+    }
+    game.score = checkpoint.score;
+    game.upcoming_blocks.clear();
+    for (int piece : checkpoint.preview) {
+        if (piece >= 0) game.upcoming_blocks.push_back(blockAt(piece));
+    }
+    return game;
+}
+
+BlockStatus traceMoveAction(const TraceMove& move)
+{
+    if (move.piece >= static_cast<int>(k_blocks.size())
+        || move.rotation >= static_cast<int>(k_blocks[move.piece]->rotations.size())) {
+        throw std::runtime_error("Trace move refers to an unknown piece or rotation.");
+    }
+    return BlockStatus(move.x, &k_blocks[move.piece]->rotations[move.rotation]);
+}
@@ -0,0 +1,127 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "models.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// --- Binary game trace ---
+// Records the piece sequence and every chosen (rotation, x) of a game, plus periodic board
+// checkpoints, so that a long game can be reproduced from the nearest checkpoint instead of
+// from move 0. Integers and IEEE doubles are written little-endian whatever the host order.
+//
+//   header      "TTRC" u16 version, u16 width, u16 height, u16 buffer_height,
+//               u32 checkpoint_interval, u32 model_length, u32 num_weights, f64 weights[]
+//   'C' record  checkpoint before move `move_index`:
+//               u64 move_index, i32 score, u8 preview[2], u8 cells[grid_height * width]
+//   'M' record  u16 count, u16 moves[count] (the moves following the last checkpoint)
+//   'E' record  u64 total_moves, i32 final_score (missing if the process died)
+//
+// Pieces are indices into k_blocks; a cell / preview byte holds index + 1 (0 = empty).
+// A move packs bits 0-2 piece, bits 3-4 rotation index, bits 5-10 x offset.
+
+constexpr std::uint32_t k_trace_version = 1;
+constexpr std::uint32_t k_default_checkpoint_interval = 4096;
+
+struct TraceMove {
+    int piece = 0;    // Index into k_blocks
+    int rotation = 0; // Index into Block::rotations
+    int x = 0;
+};
+
+std::uint16_t encodeTraceMove(const TraceMove& move);
+TraceMove decodeTraceMove(std::uint16_t packed);
+
+// Index of `block` in k_blocks, -1 if it is not one of them
+int traceBlockIndex(const Block* block);
+
+class TraceWriter {
+public:
+    // Writes the header. `model` is stored so the replay tool can re-run the policy.
+    // Throws std::runtime_error if the file cannot be opened.
+    TraceWriter(const std::string& path, const Game& game, const AssessmentModel& model,
+        std::uint32_t checkpoint_interval = k_default_checkpoint_interval);
+    ~TraceWriter();
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+
+    // Call with the game state *before* executeAction(game, action). Writes a checkpoint
+    // every checkpoint_interval moves (including move 0).
+    void recordMove(const Game& game, const BlockStatus& action);
+    // Writes the end record and flushes; later calls do nothing.
+    void finish(const Game& game);
+
+    std::uint64_t moves() const { return moves_; }
+
+private:
+    void writeCheckpoint(const Game& game);
+    void flushMoves();
+    void put(const void* data, size_t size);
+    template <class T>
+    void putValue(T value); // Little-endian, see trace.cpp
+    void flushBuffer();
+
+    std::ofstream file_;
+    std::vector<char> buffer_; // Written to file_ in large blocks
+    std::vector<std::uint16_t> pending_moves_;
+    std::uint32_t checkpoint_interval_;
+    std::uint64_t moves_ = 0;
+    bool finished_ = false;
+};
+
+struct TraceCheckpoint {
+    std::uint64_t move_index = 0;
+    int score = 0;
+    int preview[2] = { -1, -1 };      // Piece indices, -1 if none
+    std::vector<std::uint8_t> cells; // grid_height * width, row-major from y = 0
+};
+
+class TraceReader {
+public:
+    // Reads the header and indexes every record. A trace cut short by a crash is accepted
+    // up to its last complete record. Throws std::runtime_error on a malformed file.
+    explicit TraceReader(const std::string& path);
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+    int bufferHeight() const { return buffer_height_; }
+    std::uint32_t checkpointInterval() const { return checkpoint_interval_; }
+    int modelLength() const { return model_length_; }
+    const std::vector<double>& weights() const { return weights_; }
+
+    std::uint64_t moveCount() const { return moves_.size(); }
+    // Throws std::runtime_error if the move names a piece or rotation outside k_blocks
+    TraceMove move(std::uint64_t index) const;
+    bool finished() const { return finished_; }
+    int finalScore() const { return final_score_; }
+
+    size_t checkpointCount() const { return checkpoint_offsets_.size(); }
+    std::uint64_t checkpointMove(size_t index) const { return checkpoint_moves_[index]; }
+    // Last checkpoint at or before `move_index`
+    size_t checkpointBefore(std::uint64_t move_index) const;
+    TraceCheckpoint loadCheckpoint(size_t index) const;
+
+private:
+    std::string path_;
+    int width_ = 0;
+    int height_ = 0;
+    int buffer_height_ = 0;
+    std::uint32_t checkpoint_interval_ = 0;
+    int model_length_ = 0;
+    std::vector<double> weights_;
+    std::vector<std::uint16_t> moves_;
+    std::vector<std::uint64_t> checkpoint_offsets_; // File offset of each checkpoint payload
+    std::vector<std::uint64_t> checkpoint_moves_;
+    bool finished_ = false;
+    int final_score_ = 0;
+};
+
+// Rebuilds the game at `checkpoint` (board, score, preview) on top of createNewGame().
+Game restoreCheckpoint(const TraceReader& reader, const TraceCheckpoint& checkpoint);
+
+// The BlockStatus a recorded move stands for (rotation pointer into k_blocks)
+BlockStatus traceMoveAction(const TraceMove& move);
+
+#endif // TRACE_H
@@ -1,20 +1,36 @@
 #include "training.h"
+#include "distributed.h"
 #include "game.h" // 用于 runGameForTraining
+#include "instrumentation.h"
+#include "metrics.h"
 #include "models.h" // 可能需要类型定义，尽管 game.h 已包含
+#include "optimizer.h"
+#include "training_state.h"
 #include <algorithm> // 用于 std::sort, std::min_element, std::max_element
+#include <atomic>
+#include <cerrno>
 #include <chrono> // 用于计时
 #include <cmath> // 用于 std::sqrt, std::pow
-#include <future> // 用于 std::async, std::future
+#include <condition_variable>
+#include <cstdlib> // 用于 std::atoi, std::strtoul
+#include <cstring> // 用于 std::strerror
+#include <exception> // 用于 std::exception_ptr
+#include <functional>
 #include <iomanip> // 用于 std::fixed, std::setprecision
 #include <iostream>
 #include <memory> // For std::shared_ptr
+#include <mutex>
 #include <numeric> // 用于 std::accumulate, std::inner_product
 #include <random>
 #include <sstream> // 用于 ostringstream
+#include <stdexcept>
+#include <string>
 #include <thread> // 用于 std::thread::hardware_concurrency
 #include <vector>
 
-// CEM
+#include <unistd.h> // getpid, readlink
+
+// CEM / CMA-ES
 
 // Include spdlog headers
 #include <spdlog/spdlog.h>
@@ -23,15 +39,11 @@
 #include <spdlog/fmt/ostr.h> // Required for custom types like vectors if needed directly in spdlog format strings (though format_vector avoids this)
 const int k_num_features = 8; // 核心特征数量
 const int k_num_params = k_num_features + 1; // 权重 a0 到 an (如果像 Python 一样使用，则包含偏置/常数项)
-const int k_population_size = 100; // 种群大小
+const int k_population_size = 100; // CEM 种群大小 (CMA-ES 默认 4 + 3 ln n)
 const double k_elite_frac = 0.1; // 精英比例
 const int k_num_iterations = 50; // 迭代次数
 const int k_num_games_per_eval = 8; // 每次评估的游戏数
-const double k_inital_std_dev = 5.0; // 初始标准差
-const double k_std_dev_epsilon = 1e-6; // 防止 sigma 变为零
-
-// 确定最大工作线程数 (类似于 Python 的 os.cpu_count())
-const unsigned int MAX_WORKERS = 3 * std::max(1U, std::thread::hardware_concurrency());
+const double k_inital_std_dev = 5.0; // 初始标准差 (CMA-ES 的初始步长)
 
 // --- Global Logger Pointer ---
 // Declare the logger pointer globally, initialize in main
@@ -72,75 +84,141 @@ std::string format_vector(const std::vector<double>& vec) {
 }
 
 
-// --- 数值计算辅助函数 ---
-
-// 计算向量的平均值
-double calculateMean(const std::vector<double>& v)
-{
-    if (v.empty())
-        return 0.0;
-    return std::accumulate(v.begin(), v.end(), 0.0) / v.size();
-}
-
-// 计算向量的标准差
-double calculateStdDev(const std::vector<double>& v, double mean)
-{
-    if (v.size() < 2)
-        return 0.0; // 0 或 1 个元素的标准差为 0
-    double sq_sum = std::inner_product(v.begin(), v.end(), v.begin(), 0.0,
-        std::plus<>(), [mean](double a, double b) {
-            return (a - mean) * (b - mean);
-        });
-    // 使用总体标准差 (除以 N)，与 numpy 默认行为一致
-    return std::sqrt(sq_sum / v.size());
-}
-
 // --- 评估函数 ---
 
 // 用于保存 evaluate_parameters 结果的结构体
 struct EvalResult {
     int index;
     double average_score;
+    std::vector<GameRecord> games {}; // 每局指标，由调用线程写入 game_metrics
 };
 
+// --- 每局游戏的指标 (CSV, 后台线程批量写入) ---
+// 初始化于 main；为空时不记录
+std::unique_ptr<MetricsSink> game_metrics = nullptr;
+
+// splitmix64 的终结函数
+std::uint64_t mixBits(std::uint64_t x)
+{
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// 第 game 局的种子只由运行种子、参数编号和局号决定，
+// 与哪个线程或工作进程运行它无关，因此 --seed 相同的运行 (包括中断后 --resume) 结果相同
+std::uint32_t gameSeed(std::uint32_t run_seed, std::uint32_t params_id, int game)
+{
+    std::uint64_t h = mixBits(run_seed);
+    h = mixBits(h ^ params_id);
+    h = mixBits(h ^ static_cast<std::uint64_t>(game));
+    return static_cast<std::uint32_t>(h >> 32);
+}
+
 // 通过运行多个游戏来评估单组参数的函数
-// 接收索引用于日志记录
-EvalResult evaluate_parameters(int index, const std::vector<double>& params)
+// index: 候选在种群中的下标；params_id: 整个训练中唯一的参数编号 (写入指标)；run_seed: 运行种子
+// 每局的指标放在结果的 games 中 (本地评估交给调用线程写入，工作进程随结果发回)
+EvalResult evaluate_parameters(int index, std::uint32_t params_id, std::uint32_t run_seed, const std::vector<double>& params)
 {
-    // Log parameters being evaluated
-    log_safe("Task ", index, ": Starting evaluation with params: ", format_vector(params));
-    auto start_time = std::chrono::high_resolution_clock::now();
     double total_score = 0;
-
-    // Create a thread-local random number generator for game simulation if needed
-    // static thread_local std::mt19937 game_rng(std::random_device{}());
-    // Pass game_rng to runGameForTraining if it accepts an RNG
+    std::vector<GameRecord> games;
+    games.reserve(k_num_games_per_eval);
 
     for (int i = 0; i < k_num_games_per_eval; ++i) {
-        // Reduced verbosity for per-game logs
-        log_safe("Task ", index, ": Starting game ", i + 1, "/", k_num_games_per_eval);
-        int score = runGameForTraining(params); // Assuming runGameForTraining is thread-safe or uses thread-local RNG
-        total_score += score;
-        log_safe("Task ", index, ": Finished game ", i + 1, "/", k_num_games_per_eval, ", Score: ", score);
+        std::uint32_t seed = gameSeed(run_seed, params_id, i); // 指标中记录种子以便复现单局
+        auto game_start = std::chrono::steady_clock::now();
+        TrainingGameResult game = runGameForTraining(params, seed);
+        std::chrono::duration<double, std::milli> wall = std::chrono::steady_clock::now() - game_start;
+        total_score += game.steps;
+        games.push_back({ params_id, static_cast<std::uint32_t>(i), seed, game.score, game.steps, wall.count() });
     }
 
     double avg_score = (k_num_games_per_eval > 0) ? (total_score / k_num_games_per_eval) : 0.0;
-    auto end_time = std::chrono::high_resolution_clock::now();
-    std::chrono::duration<double> duration = end_time - start_time;
+    return { index, avg_score, std::move(games) };
+}
 
-    // Log evaluation result
-    log_safe("Task ", index, ": Evaluation finished in ", std::fixed, std::setprecision(2), duration.count(), "s. Avg Score: ", avg_score);
-    return { index, avg_score };
+// 把一个候选的每局指标写入文件；在检查点把它标记为已评估之前调用，
+// 否则中断后 --resume 会跳过这个候选，而它的指标还留在内存里的批次中
+void recordCandidateGames(const std::vector<GameRecord>& games)
+{
+    if (!game_metrics) return;
+    for (const GameRecord& game : games) game_metrics->record(game);
+    game_metrics->flush();
+}
+
+// 用 num_threads 个评估线程评估 population 中下标为 pending 的候选。
+// 线程 t 先按 placement 的第 t 个位置绑定 CPU，之后才分配自己的游戏状态
+// (Linux 首次访问分配内存，因此都落在线程所在的 NUMA 节点上)。
+// on_result 在调用线程上依次调用；评估线程或 on_result 抛出的异常在所有线程结束后重新抛出。
+void evaluateLocally(const std::vector<int>& pending, const std::vector<std::vector<double>>& population,
+    std::uint32_t first_params_id, std::uint32_t run_seed, int num_threads, const CpuPlacement& placement,
+    const std::function<void(const EvalResult&)>& on_result)
+{
+    std::atomic<size_t> next { 0 };
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::vector<EvalResult> done;
+    std::exception_ptr error;
+
+    std::vector<std::thread> threads;
+    const int count = std::min(num_threads, static_cast<int>(pending.size()));
+    threads.reserve(count);
+    for (int t = 0; t < count; ++t) {
+        threads.emplace_back([&, t] {
+            if (!placement.pinCurrentThread(t)) {
+                log_safe("WARN: cannot pin evaluation thread ", t, " to ", placement.describe(t), ": ", std::strerror(errno));
+            }
+            try {
+                for (size_t k = next++; k < pending.size(); k = next++) {
+                    int i = pending[k];
+                    EvalResult result = evaluate_parameters(i, first_params_id + static_cast<std::uint32_t>(i), run_seed, population[i]);
+                    std::lock_guard<std::mutex> lock(mutex);
+                    done.push_back(std::move(result));
+                    ready.notify_one();
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error) error = std::current_exception();
+                next = pending.size(); // Other threads stop after their current candidate
+                ready.notify_one();
+            }
+        });
+    }
+
+    size_t received = 0;
+    std::vector<EvalResult> batch;
+    std::unique_lock<std::mutex> lock(mutex);
+    while (received < pending.size() && !error) {
+        ready.wait(lock, [&] { return !done.empty() || error; });
+        batch.swap(done);
+        lock.unlock();
+        try {
+            for (const EvalResult& result : batch) {
+                on_result(result);
+                received++;
+            }
+        } catch (...) {
+            lock.lock();
+            if (!error) error = std::current_exception();
+            next = pending.size(); // 评估线程完成当前候选后退出，之后统一 join
+            break;
+        }
+        batch.clear();
+        lock.lock();
+    }
+    lock.unlock();
+    for (auto& thread : threads) thread.join();
+    if (error) std::rethrow_exception(error);
 }
 
 // --- 训练函数 ---
 
-void runTraining()
+void runTraining(const TrainingOptions& options)
 {
-    log_safe("--- Starting Tetris CEM Training (C++) ---");
-    log_safe("Parameters: Population Size=", k_population_size, ", Elite Fraction=", k_elite_frac,
-        ", Iterations=", k_num_iterations, ", Games per Eval=", k_num_games_per_eval,
-        ", Max Workers=", MAX_WORKERS, ", Initial Std Dev=", k_inital_std_dev);
+#ifdef TETRIS_INSTRUMENT
+    instrument::setPerGameDump(false); // 训练中游戏数量很多，只在结束时输出汇总
+#endif
+    log_safe("--- Starting Tetris Training (C++) ---");
 
     // --- 初始化 ---
     std::vector<double> initial_good_params = {
@@ -151,71 +229,153 @@ void runTraining()
         return;
     }
 
-    auto mu = initial_good_params;
-    std::vector<double> sigma(k_num_params, k_inital_std_dev);
-    // std::vector<double> sigma = {
-    //     1.6127, 1.5766, 0.5512, 1.9276, 1.5725, 0.4238, 0.4413, 2.5621, 2.3811
-    // };
+    // --- 训练状态 (优化器状态, 采样生成器, 当前种群及其得分) ---
+    // 每次采样、每个候选评估完成、每次分布更新后都写入检查点，--resume 时从检查点继续。
+    TrainingState state;
+    bool resumed = options.resume && loadTrainingState(options.checkpoint_path, state);
+    if (resumed && !options.optimizer.empty() && options.optimizer != state.optimizer) {
+        throw std::runtime_error("Checkpoint was written by optimizer '" + state.optimizer + "', not '" + options.optimizer + "'");
+    }
+    if (resumed && options.seed && *options.seed != state.seed) {
+        throw std::runtime_error("Checkpoint was written with --seed " + std::to_string(state.seed) + ", not "
+            + std::to_string(*options.seed));
+    }
+    const std::string optimizer_name = resumed ? state.optimizer : (options.optimizer.empty() ? "cem" : options.optimizer);
+    const int population_size = options.population > 0 ? options.population : (optimizer_name == "cem" ? k_population_size : 0);
+    std::unique_ptr<Optimizer> optimizer = makeOptimizer(optimizer_name, initial_good_params, k_inital_std_dev,
+        population_size, k_elite_frac);
+    if (resumed) {
+        optimizer->deserialize(state.optimizer_state);
+        if (!state.population.empty() && static_cast<int>(state.population.size()) != optimizer->populationSize()) {
+            throw std::runtime_error("Checkpoint population " + std::to_string(state.population.size()) + " does not match "
+                + std::to_string(optimizer->populationSize()));
+        }
+        int done = 0;
+        for (unsigned char e : state.evaluated) done += e;
+        log_safe("Resuming from ", options.checkpoint_path, " at iteration ", state.iteration + 1,
+            " (", done, "/", state.population.size(), " candidates already evaluated)");
+    } else {
+        if (options.resume) {
+            log_safe("No checkpoint at ", options.checkpoint_path, ", starting a new run.");
+        }
+        state.optimizer = optimizer->name();
+        state.optimizer_state = optimizer->serialize();
+        // std::vector<double> sigma = {
+        //     1.6127, 1.5766, 0.5512, 1.9276, 1.5725, 0.4238, 0.4413, 2.5621, 2.3811
+        // };
+
+        // --- 随机数生成器设置 ---
+        // 主线程采样使用独立的生成器；游戏种子由运行种子派生 (见 gameSeed)。
+        state.seed = options.seed ? *options.seed : std::random_device {}();
+        state.rng.seed(state.seed);
+    }
+    const int num_iterations = options.iterations > 0 ? options.iterations : k_num_iterations;
+
+    // --- 评估线程与 CPU 绑定 ---
+    // 默认每个可用 CPU 一个线程，避免在共享机器上超额订阅
+    std::vector<int> cpus = options.cpuset.empty() ? allowedCpus() : options.cpuset;
+    if (cpus.empty()) {
+        for (unsigned int cpu = 0; cpu < std::max(1U, std::thread::hardware_concurrency()); ++cpu) cpus.push_back(cpu);
+    }
+    const CpuPlacement placement(cpus, options.pin);
+    const int num_threads = options.threads > 0 ? options.threads : static_cast<int>(cpus.size());
+
+    log_safe("Parameters: Optimizer=", optimizer->name(), ", Population Size=", optimizer->populationSize(),
+        ", Elite Fraction=", k_elite_frac, ", Iterations=", num_iterations, ", Games per Eval=", k_num_games_per_eval,
+        ", Threads=", num_threads, ", Initial Std Dev=", k_inital_std_dev, ", Seed=", state.seed);
+    log_safe("CPUs: ", formatCpuList(placement.cpus()), " on ", placement.numNodes(), " NUMA node(s), pinning: ",
+        pinModeName(placement.mode()));
+    if (placement.mode() != PinMode::None) {
+        for (int t = 0; t < num_threads; ++t) {
+            log_safe("  Thread ", t, " -> ", placement.describe(t));
+        }
+    }
+
+    // --- 分布式评估: 候选参数通过 Unix socket 发给工作进程 ---
+    std::unique_ptr<WorkerPool> pool;
+    if (options.workers > 0 || options.listen) {
+        pool = std::make_unique<WorkerPool>(options.socket_path);
+        if (options.workers > 0) {
+            pool->spawnLocalWorkers(options.executable, options.workers, &placement);
+        }
+        log_safe("Distributed evaluation on ", options.socket_path, ": ", options.workers, " local workers",
+            options.listen ? ", accepting external workers" : "");
+    }
     // Log initial parameters
-    log_safe("Initial mu: ", format_vector(mu));
-    log_safe("Initial sigma: ", format_vector(sigma));
-
-
-    // --- 随机数生成器设置 ---
-    // 主线程采样使用独立的生成器。
-    // 注意: evaluate_parameters 理想情况下需要线程局部随机数生成器。
-    std::random_device rd;
-    std::mt19937 main_rng(rd());
-
-    // --- CEM 主循环 ---
-    // CEM (Cross-Entropy Method) 是一种基于优化的方法，
-    // 通过迭代地从参数分布中采样，评估样本，选择表现最好的样本（精英），
-    // 并使用这些精英来更新参数分布（均值和标准差），逐步逼近最优参数。
-    for (int itr = 0; itr < k_num_iterations; ++itr) {
-        log_safe("\n--- Iteration ", itr + 1, "/", k_num_iterations, " ---");
+    log_safe("Initial mu: ", format_vector(optimizer->mean()));
+    log_safe("Initial sigma: ", format_vector(optimizer->stdDevs()));
+
+    // --- 主循环 ---
+    // CEM (Cross-Entropy Method) 和 CMA-ES 都是基于采样的优化方法：
+    // 迭代地从参数分布中采样 (ask)，评估样本，再用得分更新分布 (tell)，逐步逼近最优参数。
+    // CEM 对每个参数独立拟合正态分布；CMA-ES 自适应完整的协方差矩阵，能沿相关参数的方向搜索。
+    const int population_size_used = optimizer->populationSize();
+    for (int itr = state.iteration; itr < num_iterations; ++itr) {
+        log_safe("\n--- Iteration ", itr + 1, "/", num_iterations, " ---");
         auto iteration_start_time = std::chrono::high_resolution_clock::now();
         // Log parameters for the current iteration
-        log_safe("Current mu: ", format_vector(mu));
-        log_safe("Current sigma: ", format_vector(sigma));
+        log_safe("Current mu: ", format_vector(optimizer->mean()));
+        log_safe("Current sigma: ", format_vector(optimizer->stdDevs()));
 
         // 1. 采样种群 (Sampling)
-        // 从当前的参数分布（由均值 mu 和标准差 sigma 定义的正态分布）中
-        // 随机抽取 k_population_size 组参数。每一组参数代表一个潜在的解决方案。
-        std::vector<std::vector<double>> population_params(k_population_size, std::vector<double>(k_num_params));
-        for (int i = 0; i < k_population_size; ++i) {
-            for (int j = 0; j < k_num_params; ++j) {
-                std::normal_distribution<double> dist(mu[j], sigma[j]);
-                population_params[i][j] = dist(main_rng);
-            }
+        // 从优化器当前的参数分布中随机抽取一个种群。每一组参数代表一个潜在的解决方案。
+        // 从检查点恢复时，本迭代的种群可能已经采样过，直接沿用。
+        if (state.population.empty()) {
+            state.resetPopulation(optimizer->ask(state.rng));
+            saveTrainingState(options.checkpoint_path, state);
         }
+        const std::vector<std::vector<double>>& population_params = state.population;
 
         // 2. 并行评估 (Evaluation)
         // 使用多个工作线程并行地评估种群中的每一组参数。
         // 对于每组参数，运行 k_num_games_per_eval 次游戏，计算平均得分作为其性能指标。
-        log_safe("Starting parallel evaluation of ", k_population_size, " parameter sets using ", MAX_WORKERS, " workers...");
         auto eval_start_time = std::chrono::high_resolution_clock::now();
+        int completed_count = 0;
+        const std::uint32_t first_params_id = static_cast<std::uint32_t>(itr) * population_size_used; // 指标中的参数编号
+
+        if (pool) {
+            // 分布式: 未评估的候选作为任务分发给工作进程，结果到达时写入检查点
+            log_safe("Starting distributed evaluation of ", population_size_used, " parameter sets (",
+                pool->connectedWorkers(), " workers connected)...");
+            std::vector<EvalTask> tasks;
+            for (int i = 0; i < population_size_used; ++i) {
+                if (state.evaluated[i]) continue;
+                tasks.push_back({ first_params_id + static_cast<std::uint32_t>(i), state.seed, population_params[i] });
+            }
+            pool->evaluate(tasks, [&](const EvalReply& reply) {
+                std::uint32_t index = reply.id - first_params_id;
+                if (reply.id < first_params_id || index >= static_cast<std::uint32_t>(population_size_used)) {
+                    throw std::logic_error("Distributed reply for parameter set " + std::to_string(reply.id)
+                        + " outside iteration " + std::to_string(itr + 1));
+                }
+                recordCandidateGames(reply.games); // 工作进程的每局指标
+                state.scores[index] = reply.average_score;
+                state.evaluated[index] = 1;
+                saveTrainingState(options.checkpoint_path, state);
+                completed_count++;
+            });
+        } else {
+            log_safe("Starting parallel evaluation of ", population_size_used, " parameter sets using ", num_threads, " threads...");
+            // 检查点中已评估的候选跳过
+            std::vector<int> pending;
+            for (int i = 0; i < population_size_used; ++i) {
+                if (!state.evaluated[i]) pending.push_back(i);
+            }
 
-        std::vector<std::future<EvalResult>> futures;
-        futures.reserve(k_population_size);
-
-        // 启动异步任务来评估每个参数集
-        for (int i = 0; i < k_population_size; ++i) {
-            // 异步启动任务
-            futures.push_back(std::async(std::launch::async, evaluate_parameters, i, population_params[i]));
+            // 收集评估结果: 每个结果都立即写入检查点
+            evaluateLocally(pending, population_params, first_params_id, state.seed, num_threads, placement, [&](const EvalResult& result) {
+                recordCandidateGames(result.games);
+                state.scores[result.index] = result.average_score;
+                state.evaluated[result.index] = 1;
+                saveTrainingState(options.checkpoint_path, state);
+                completed_count++;
+            });
         }
 
-        // 收集评估结果
-        // 等待所有并行评估任务完成，并收集它们的平均得分。
         std::vector<EvalResult> results;
-        results.reserve(k_population_size);
-        int completed_count = 0;
-        for (auto& fut : futures) {
-            results.push_back(fut.get()); // 阻塞直到 future 就绪
-            completed_count++;
-            // Optional: Log progress less frequently if needed
-            // if (completed_count % (k_population_size / 10) == 0 || completed_count == k_population_size) {
-            //     log_safe("  Evaluation progress: ", completed_count, "/", k_population_size, " parameter sets evaluated.");
-            // }
+        results.reserve(population_size_used);
+        for (int i = 0; i < population_size_used; ++i) {
+            results.push_back({ i, state.scores[i] });
         }
 
         auto eval_end_time = std::chrono::high_resolution_clock::now();
@@ -246,64 +406,17 @@ void runTraining()
         }
 
 
-        // 3. 选择精英 (Selection)
-        // 从排序后的结果中选择得分最高的 top k_elite_frac 百分比的参数组作为“精英”。
-        // 这些精英代表了当前迭代中最好的解决方案。
-        int num_elites = static_cast<int>(k_population_size * k_elite_frac);
-        if (num_elites == 0 && k_population_size > 0)
-            num_elites = 1; // 如果可能，确保至少有一个精英
-
-        log_safe("Selecting top ", num_elites, " elites (", k_elite_frac * 100, "%)");
-
-        std::vector<std::vector<double>> elite_params;
-        elite_params.reserve(num_elites);
-        for (int i = 0; i < num_elites && i < results.size(); ++i) {
-            elite_params.push_back(population_params[results[i].index]);
-            // Optional: Log selected elite params if needed (can be verbose)
-            // log_safe("  Elite ", i+1, " (Score: ", results[i].average_score, "): ", format_vector(population_params[results[i].index]));
-        }
-
-        if (elite_params.empty()) {
-            log_safe("WARNING: No elite parameters selected. Check scores or elite fraction. Keeping previous mu/sigma.");
-            // 可选：保留旧的 mu/sigma 或重置 sigma？暂时保留旧的。
-            continue;
-        }
-
-        // 4. 更新分布 (Update)
-        // 使用选出的精英参数组来更新下一次迭代的参数分布。
-        // 新的均值 (mu) 是精英参数各维度的平均值。
-        // 新的标准差 (sigma) 是精英参数各维度的标准差（加上一个小的 epsilon 防止其变为零）。
-        // 这个步骤使得下一次采样的参数更可能接近于当前找到的较优解区域。
-        std::vector<double> next_mu(k_num_params, 0.0);
-        std::vector<double> next_sigma(k_num_params, 0.0);
-
-        // 计算新的均值 (mu)
-        for (int j = 0; j < k_num_params; ++j) {
-            double sum = 0.0;
-            std::vector<double> param_values_j;
-            param_values_j.reserve(elite_params.size());
-            for (const auto& elite : elite_params) {
-                param_values_j.push_back(elite[j]);
-            }
-            next_mu[j] = calculateMean(param_values_j);
-        }
-
-        // 计算新的标准差 (sigma)
-        for (int j = 0; j < k_num_params; ++j) {
-            std::vector<double> param_values_j;
-            param_values_j.reserve(elite_params.size());
-            for (const auto& elite : elite_params) {
-                param_values_j.push_back(elite[j]);
-            }
-            next_sigma[j] = calculateStdDev(param_values_j, next_mu[j]) + k_std_dev_epsilon; // 添加 epsilon
-        }
-
-        mu = next_mu;
-        sigma = next_sigma;
+        // 3. 更新分布 (Update)
+        // 把整个种群及其得分交给优化器：CEM 用得分最高的精英重新拟合均值和标准差，
+        // CMA-ES 用加权的优胜者更新均值、进化路径、协方差矩阵和步长。
+        optimizer->tell(population_params, state.scores);
+        state.advance(itr + 1, optimizer->serialize());
+        saveTrainingState(options.checkpoint_path, state);
 
         // Log updated parameters
-        log_safe("  Updated mu: ", format_vector(mu));
-        log_safe("  Updated sigma: ", format_vector(sigma));
+        log_safe("  Updated mu: ", format_vector(optimizer->mean()));
+        log_safe("  Updated sigma: ", format_vector(optimizer->stdDevs()));
+        log_safe("  Games evaluated so far: ", static_cast<long long>(itr + 1) * population_size_used * k_num_games_per_eval);
 
         auto iteration_end_time = std::chrono::high_resolution_clock::now();
         std::chrono::duration<double> iteration_duration = iteration_end_time - iteration_start_time;
@@ -313,16 +426,118 @@ void runTraining()
     // --- 训练结束 ---
     log_safe("\n--- Training Finished! ---");
     log_safe("Final Estimated Mean Parameters (mu):");
-    log_safe(format_vector(mu)); // Log final parameters to file
+    log_safe(format_vector(optimizer->mean())); // Log final parameters to file
 
     // Also print final result to console for convenience
     std::cout << "\n--- Training Finished! ---" << std::endl;
     std::cout << "Final Estimated Mean Parameters (mu):" << std::endl;
-    std::cout << format_vector(mu) << std::endl;
+    std::cout << format_vector(optimizer->mean()) << std::endl;
     std::cout << "Check 'training_log.log' for detailed logs." << std::endl;
+
+#ifdef TETRIS_INSTRUMENT
+    instrument::printSummary(std::cout, instrument::globalSnapshot(), "Training instrumentation (all games)");
+#endif
+}
+
+// Path of the running binary, so spawned workers run the same build
+std::string selfExecutable(const char* argv0)
+{
+    char path[4096];
+    ssize_t n = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (n <= 0) return argv0;
+    path[n] = '\0';
+    return path;
 }
 
-int main() {
+// tetris_train --worker <socket>: evaluates candidates sent by a coordinator until it shuts down
+int runWorkerProcess(const std::string& socket_path)
+{
+    try {
+        spdlog::init_thread_pool(8192, 1);
+        async_file = spdlog::basic_logger_mt<spdlog::async_factory>("async_file_logger",
+            "logs/worker_" + std::to_string(getpid()) + ".log");
+        async_file->set_level(spdlog::level::info);
+        async_file->set_pattern("[%Y-%m-%d %H:%M:%S.%e] [%n] [%l] %v");
+    } catch (const spdlog::spdlog_ex& ex) {
+        std::cerr << "Log initialization failed: " << ex.what() << std::endl;
+        return 1;
+    }
+    int status = 1;
+    try {
+        // 每局指标随结果发回协调进程，由它写入 --metrics 文件
+        status = runWorker(socket_path, [](const EvalTask& task) {
+            EvalResult result = evaluate_parameters(static_cast<int>(task.id), task.id, task.seed, task.params);
+            EvalReply reply;
+            reply.average_score = result.average_score;
+            reply.games = std::move(result.games);
+            return reply;
+        });
+    } catch (const std::exception& e) {
+        log_safe("FATAL ERROR in worker: ", e.what());
+    }
+    spdlog::shutdown();
+    return status;
+}
+
+int main(int argc, char* argv[]) {
+    // --- Parse Command Line Arguments ---
+    // tetris_train [--optimizer cem|cma_es] [--population N] [--iterations N] [--seed N]
+    //              [--resume] [--checkpoint <path>] [--metrics <path>]
+    //              [--threads N] [--cpuset <list>] [--pin none|core|node]
+    //              [--workers N] [--listen] [--socket <path>]
+    // tetris_train --worker <socket>
+    TrainingOptions options;
+    options.executable = selfExecutable(argv[0]);
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--resume") {
+            options.resume = true;
+        } else if (arg == "--checkpoint" && i + 1 < argc) {
+            options.checkpoint_path = argv[++i];
+        } else if (arg == "--metrics" && i + 1 < argc) {
+            options.metrics_path = argv[++i];
+        } else if (arg == "--optimizer" && i + 1 < argc) {
+            options.optimizer = argv[++i];
+        } else if (arg == "--population" && i + 1 < argc) {
+            options.population = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--iterations" && i + 1 < argc) {
+            options.iterations = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--seed" && i + 1 < argc) {
+            options.seed = static_cast<std::uint32_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (arg == "--threads" && i + 1 < argc) {
+            options.threads = std::max(0, std::atoi(argv[++i]));
+        } else if ((arg == "--cpuset" || arg == "--pin") && i + 1 < argc) {
+            try {
+                if (arg == "--cpuset") {
+                    options.cpuset = parseCpuList(argv[++i]);
+                } else {
+                    options.pin = parsePinMode(argv[++i]);
+                }
+            } catch (const std::invalid_argument& e) {
+                std::cerr << e.what() << std::endl;
+                return 1;
+            }
+        } else if (arg == "--workers" && i + 1 < argc) {
+            options.workers = std::max(0, std::atoi(argv[++i]));
+        } else if (arg == "--listen") {
+            options.listen = true;
+        } else if (arg == "--socket" && i + 1 < argc) {
+            options.socket_path = argv[++i];
+        } else if (arg == "--worker" && i + 1 < argc) {
+            return runWorkerProcess(argv[++i]);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--optimizer cem|cma_es] [--population N] [--iterations N] [--seed N]\n"
+                      << "       " << std::string(std::string(argv[0]).size(), ' ')
+                      << " [--resume] [--checkpoint <path>] [--metrics <path>]\n"
+                      << "       " << std::string(std::string(argv[0]).size(), ' ')
+                      << " [--threads N] [--cpuset <list>] [--pin none|core|node]\n"
+                      << "       " << std::string(std::string(argv[0]).size(), ' ')
+                      << " [--workers N] [--listen] [--socket <path>]\n"
+                      << "       " << argv[0] << " --worker <socket>" << std::endl;
+            return 1;
+        }
+    }
+
     // --- Initialize Logging ---
     try {
         // Ensure the "logs" directory exists or handle creation failure
@@ -353,17 +568,21 @@ int main() {
 
     std::cout << "--- Starting Tetris Training ---" << std::endl;
     std::cout << "Logging detailed output to 'logs/async_log.log'" << std::endl; // Update path
+    std::cout << "Per-game metrics in '" << options.metrics_path << "'" << std::endl;
     try {
-        runTraining(); // Call the main training function
+        game_metrics = std::make_unique<MetricsSink>(options.metrics_path);
+        runTraining(options); // Call the main training function
     } catch (const std::exception& e) {
         log_safe("FATAL ERROR during training: ", e.what()); // Log exception to file
         std::cerr << "An error occurred during training: " << e.what() << std::endl;
+        game_metrics.reset();
         spdlog::shutdown(); // Ensure logs are flushed on error exit
         return 1; // Indicate failure
     } 
     catch (...) {
         log_safe("FATAL UNKNOWN ERROR during training."); // Log unknown exception
         std::cerr << "An unknown error occurred during training." << std::endl;
+        game_metrics.reset();
         spdlog::shutdown(); // Ensure logs are flushed on error exit
         return 1; // Indicate failure
     }
@@ -371,6 +590,7 @@ int main() {
     log_safe("--- Application End ---"); // Log application end normally
     std::cout << "--- Tetris Training Finished ---" << std::endl;
 
+    game_metrics.reset(); // Writes the remaining rows
     spdlog::shutdown(); // Shutdown spdlog to flush async logs
     return 0; // Indicate success
 }
\ No newline at end of file
@@ -1,9 +1,37 @@
 #ifndef TRAINING_H
 #define TRAINING_H
 
+#include "affinity.h"
+#include <cstdint>
+#include <optional>
+#include <string>
 #include <vector>
 
-// Function to run the Cross-Entropy Method training
-void runTraining();
+// Command-line options of tetris_train
+struct TrainingOptions {
+    std::string optimizer; // "cem" or "cma_es"; empty: cem, or whatever the resumed checkpoint used
+    int population = 0; // Candidates per iteration; 0 picks the optimizer's default
+    int iterations = 0; // 0 picks the default (k_num_iterations)
+    std::string checkpoint_path = "logs/cem_checkpoint.txt"; // Rewritten atomically while training
+    bool resume = false; // Continue from checkpoint_path if it exists
+    // Run seed: sampling starts from it and every game seed is derived from it.
+    // Empty: random_device for a new run, the checkpoint's seed on resume.
+    std::optional<std::uint32_t> seed;
+    std::string metrics_path = "logs/games.csv"; // One CSV row per evaluated game (appended), workers' games included
+
+    // Local evaluation threads (and spawned worker processes)
+    int threads = 0; // 0: one per CPU of the cpuset
+    std::vector<int> cpuset; // Empty: the CPUs this process may run on
+    PinMode pin = PinMode::None;
+
+    // Distributed evaluation: candidates go to worker processes over a Unix socket
+    int workers = 0; // Worker processes to spawn locally (fork/exec of `executable --worker`)
+    bool listen = false; // Also accept workers started elsewhere (tetris_train --worker <socket>)
+    std::string socket_path = "logs/tetris_train.sock";
+    std::string executable; // Path of this binary, for spawning workers
+};
+
+// Runs CEM or CMA-ES training over the assessment weights
+void runTraining(const TrainingOptions& options);
 
 #endif // TRAINING_H
\ No newline at end of file
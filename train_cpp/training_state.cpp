@@ -0,0 +1,143 @@
+#include "training_state.h"
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h> // fsync
+#endif
+
+namespace {
+
+const char* const k_checkpoint_magic = "tetris_cem_checkpoint";
+constexpr int k_checkpoint_version = 3;
+
+void writeVector(std::ostream& os, const char* key, const std::vector<double>& v)
+{
+    os << key << ' ' << v.size();
+    for (double x : v) os << ' ' << x;
+    os << '\n';
+}
+
+std::vector<double> readVector(std::istream& is, const char* key)
+{
+    std::string name;
+    size_t size = 0;
+    if (!(is >> name >> size) || name != key) {
+        throw std::runtime_error(std::string("Checkpoint: expected '") + key + "'.");
+    }
+    std::vector<double> v(size);
+    for (auto& x : v) {
+        if (!(is >> x)) throw std::runtime_error(std::string("Checkpoint: truncated '") + key + "'.");
+    }
+    return v;
+}
+
+} // namespace
+
+void TrainingState::resetPopulation(std::vector<std::vector<double>> params)
+{
+    population = std::move(params);
+    scores.assign(population.size(), 0.0);
+    evaluated.assign(population.size(), 0);
+}
+
+void TrainingState::advance(int next_iteration, std::vector<double> next_optimizer_state)
+{
+    iteration = next_iteration;
+    optimizer_state = std::move(next_optimizer_state);
+    population.clear();
+    scores.clear();
+    evaluated.clear();
+}
+
+void saveTrainingState(const std::string& path, const TrainingState& state)
+{
+    std::ostringstream os;
+    os.precision(std::numeric_limits<double>::max_digits10); // Exact round trip
+    os << k_checkpoint_magic << ' ' << k_checkpoint_version << '\n';
+    os << "iteration " << state.iteration << '\n';
+    os << "optimizer " << state.optimizer << '\n';
+    os << "seed " << state.seed << '\n';
+    writeVector(os, "state", state.optimizer_state);
+    os << "population " << state.population.size() << '\n';
+    for (size_t i = 0; i < state.population.size(); ++i) {
+        os << static_cast<int>(state.evaluated[i]) << ' ' << state.scores[i];
+        writeVector(os, " params", state.population[i]);
+    }
+    os << "rng " << state.rng << '\n';
+    const std::string data = os.str();
+
+    const std::string tmp_path = path + ".tmp";
+    std::FILE* file = std::fopen(tmp_path.c_str(), "wb");
+    if (!file) {
+        throw std::runtime_error("Cannot write checkpoint: " + tmp_path);
+    }
+    bool ok = std::fwrite(data.data(), 1, data.size(), file) == data.size() && std::fflush(file) == 0;
+#if defined(__unix__) || defined(__APPLE__)
+    ok = ok && fsync(fileno(file)) == 0; // Data must be on disk before the rename publishes it
+#endif
+    ok = (std::fclose(file) == 0) && ok;
+    if (!ok || std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        std::remove(tmp_path.c_str());
+        throw std::runtime_error("Failed to write checkpoint: " + path);
+    }
+}
+
+bool loadTrainingState(const std::string& path, TrainingState& state)
+{
+    std::ifstream is(path);
+    if (!is) {
+        return false;
+    }
+    std::string magic, key;
+    int version = 0;
+    if (!(is >> magic >> version) || magic != k_checkpoint_magic || version < 1 || version > k_checkpoint_version) {
+        throw std::runtime_error("Not a training checkpoint (or unsupported version): " + path);
+    }
+    TrainingState loaded;
+    size_t population_size = 0;
+    if (!(is >> key >> loaded.iteration) || key != "iteration") {
+        throw std::runtime_error("Checkpoint: expected 'iteration'.");
+    }
+    if (version == 1) {
+        // CEM-only format: mu and sigma, which is exactly CemOptimizer's serialized state
+        loaded.optimizer = "cem";
+        loaded.optimizer_state = readVector(is, "mu");
+        std::vector<double> sigma = readVector(is, "sigma");
+        loaded.optimizer_state.insert(loaded.optimizer_state.end(), sigma.begin(), sigma.end());
+    } else {
+        if (!(is >> key >> loaded.optimizer) || key != "optimizer") {
+            throw std::runtime_error("Checkpoint: expected 'optimizer'.");
+        }
+        if (version >= 3 && (!(is >> key >> loaded.seed) || key != "seed")) {
+            throw std::runtime_error("Checkpoint: expected 'seed'.");
+        }
+        loaded.optimizer_state = readVector(is, "state");
+    }
+    if (!(is >> key >> population_size) || key != "population") {
+        throw std::runtime_error("Checkpoint: expected 'population'.");
+    }
+    std::vector<std::vector<double>> population(population_size);
+    std::vector<double> scores(population_size);
+    std::vector<unsigned char> evaluated(population_size);
+    for (size_t i = 0; i < population_size; ++i) {
+        int done = 0;
+        if (!(is >> done >> scores[i])) {
+            throw std::runtime_error("Checkpoint: truncated population.");
+        }
+        evaluated[i] = static_cast<unsigned char>(done != 0);
+        population[i] = readVector(is, "params");
+    }
+    loaded.population = std::move(population);
+    loaded.scores = std::move(scores);
+    loaded.evaluated = std::move(evaluated);
+    if (!(is >> key) || key != "rng" || !(is >> loaded.rng)) {
+        throw std::runtime_error("Checkpoint: missing RNG state.");
+    }
+    state = std::move(loaded);
+    return true;
+}
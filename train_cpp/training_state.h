@@ -0,0 +1,40 @@
+#ifndef TRAINING_STATE_H
+#define TRAINING_STATE_H
+
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+// Everything runTraining() needs to continue a training run after a crash or preemption.
+// A checkpoint is taken after sampling each population, after every evaluated candidate
+// and after every distribution update, so a resumed run only re-plays unfinished games.
+struct TrainingState {
+    int iteration = 0; // Iteration in progress (or next to start)
+    std::string optimizer; // Optimizer::name() of the run
+    std::vector<double> optimizer_state; // Optimizer::serialize() after the last update
+    std::uint32_t seed = 0; // Run seed; rng starts from it and game seeds are derived from it
+    std::mt19937 rng; // Sampling generator, state after the current population was drawn
+
+    // Population of `iteration`; empty until it has been sampled
+    std::vector<std::vector<double>> population;
+    std::vector<double> scores;         // Average score per candidate
+    std::vector<unsigned char> evaluated; // 1 once scores[i] is final
+
+    // Starts a freshly sampled population, none evaluated
+    void resetPopulation(std::vector<std::vector<double>> params);
+    // Moves on to `next_iteration` with the updated distribution
+    void advance(int next_iteration, std::vector<double> next_optimizer_state);
+};
+
+// Writes `state` to `path` atomically: a temporary file in the same directory is written,
+// flushed to disk and renamed over `path`, so a crash never leaves a half-written checkpoint.
+// Throws std::runtime_error on I/O failure.
+void saveTrainingState(const std::string& path, const TrainingState& state);
+
+// Reads a checkpoint written by saveTrainingState(). Returns false if `path` does not exist;
+// throws std::runtime_error if it exists but is malformed. Version 1 checkpoints (CEM mu and
+// sigma) load as optimizer "cem"; checkpoints before version 3 load with seed 0.
+bool loadTrainingState(const std::string& path, TrainingState& state);
+
+#endif // TRAINING_STATE_H
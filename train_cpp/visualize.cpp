@@ -1,6 +1,10 @@
 #include "visualize.h"
 #include "constants.h" // For k_blocks in visualizeBoard
 #include "models.h"
+#include <algorithm>
+#include <cerrno>
+#include <charconv> // For std::to_chars
+#include <cstring> // For std::memcmp
 #include <iomanip> // For potential formatting
 #include <iostream>
 #include <string>
@@ -236,4 +240,282 @@ void visualizeDbtFeature(const std::vector<int>& features)
     if (features.size() > max_height_idx) {
         std::cout << "  Max Height: " << features[max_height_idx] << std::endl;
     }
-}
\ No newline at end of file
+}
+
+// --- FrameRenderer ---
+
+namespace {
+
+constexpr int k_status_rows = 3; // Score, blocks, action
+constexpr int k_min_frame_cols = 64;
+constexpr int k_max_rewrite_gap = 4; // A cursor move ("ESC[r;cH") takes 6-8 bytes
+
+// Appends "ESC[row;colH" (1-based) without going through printf
+void appendCursorMove(std::string& out, int row, int col)
+{
+    char text[32] = "\033[";
+    char* end = std::to_chars(text + 2, text + 14, row).ptr; // At most 11 digits and a sign
+    *end++ = ';';
+    end = std::to_chars(end, text + 27, col).ptr;
+    *end++ = 'H';
+    out.append(text, end);
+}
+
+} // namespace
+
+FrameRenderer::FrameRenderer(int fd)
+    : fd_(fd)
+{
+}
+
+void captureFrame(const Game& game, const BlockStatus& action, int y_offset, long long pieces, FrameSnapshot& out)
+{
+    const Board& board = game.board;
+    out.width = std::min(board.size.width, FrameSnapshot::k_max_width);
+    out.height = std::min(board.size.height, FrameSnapshot::k_max_rows);
+    out.score = game.score;
+    out.pieces = pieces;
+    for (size_t i = 0; i < out.preview.size(); ++i) {
+        out.preview[i] = i < game.upcoming_blocks.size() ? game.upcoming_blocks[i] : nullptr;
+    }
+    out.rotation = action.rotation;
+    out.x_offset = action.x_offset;
+    out.y_offset = y_offset;
+    out.has_assessment = action.assessment_score.has_value();
+    out.assessment = action.assessment_score.value_or(0.0);
+    out.clearable_rows = 0;
+    for (int y = 0; y < out.height; ++y) {
+        if (board.canClearLine(y)) out.clearable_rows |= std::uint64_t(1) << y;
+        char* glyphs = out.glyphs.data() + static_cast<size_t>(y) * out.width;
+        if (board.row_masks[y] == 0) {
+            std::fill(glyphs, glyphs + out.width, ' ');
+            continue;
+        }
+        for (int x = 0; x < out.width; ++x) {
+            const Block* block = board.squares[y][x];
+            glyphs[x] = block && !block->label.empty() ? block->label[0] : ' ';
+        }
+    }
+}
+
+void FrameRenderer::render(const Game& game, const BlockStatus& action, int y_offset, long long pieces)
+{
+    captureFrame(game, action, y_offset, pieces, snapshot_);
+    render(snapshot_);
+}
+
+void FrameRenderer::render(const FrameSnapshot& frame)
+{
+    const int rows = k_status_rows + frame.height + 3; // + borders and coordinates
+    const int cols = std::max(2 * frame.width + 3, k_min_frame_cols);
+    if (rows != rows_ || cols != cols_) {
+        rows_ = rows;
+        cols_ = cols;
+        has_previous_ = false;
+    }
+    frame_.assign(static_cast<size_t>(rows_) * cols_, Cell {});
+    compose(frame);
+    diff();
+    flush();
+}
+
+int FrameRenderer::put(int row, int col, const char* text, CellColor color)
+{
+    Cell* line = frame_.data() + static_cast<size_t>(row) * cols_;
+    for (; *text && col < cols_; ++text, ++col) {
+        line[col] = Cell { *text, color };
+    }
+    return col;
+}
+
+int FrameRenderer::putNumber(int row, int col, long long value)
+{
+    char text[24];
+    *std::to_chars(text, text + sizeof(text) - 1, value).ptr = '\0';
+    return put(row, col, text);
+}
+
+void FrameRenderer::put(int row, int col, char glyph, CellColor color)
+{
+    if (col < cols_) {
+        frame_[static_cast<size_t>(row) * cols_ + col] = Cell { glyph, color };
+    }
+}
+
+void FrameRenderer::compose(const FrameSnapshot& frame)
+{
+    const int width = frame.width;
+    const int height = frame.height;
+
+    // Status lines (visualizeAction)
+    int col = put(0, 0, "Current Score: ");
+    col = putNumber(0, col, frame.score);
+    col = put(0, col, "   Pieces: ");
+    putNumber(0, col, frame.pieces);
+    const auto label = [&](size_t i) { return frame.preview[i] ? frame.preview[i]->label.c_str() : "(None)"; };
+    col = put(1, 0, "Current Block: ");
+    col = put(1, col, label(0));
+    col = put(1, col, "   Next Block: ");
+    put(1, col, label(1));
+    if (frame.rotation) {
+        col = put(2, 0, "Best Action: degree=");
+        col = put(2, col, frame.rotation->label.c_str());
+        col = put(2, col, ", x=");
+        col = putNumber(2, col, frame.x_offset);
+        col = put(2, col, ", score=");
+        if (frame.has_assessment) {
+            char text[32];
+            *std::to_chars(text, text + sizeof(text) - 1, frame.assessment, std::chars_format::general, 6).ptr = '\0';
+            put(2, col, text);
+        } else {
+            put(2, col, "(N/A)");
+        }
+    }
+
+    // Board (visualizeBoard): borders, then rows top-down
+    const int top = k_status_rows;
+    const int bottom = top + height + 1;
+    put(top, 0, '+', CellColor::Cyan);
+    put(bottom, 0, '+', CellColor::Cyan);
+    for (int c = 1; c < 2 * width; ++c) {
+        put(top, c, '-', CellColor::Cyan);
+        put(bottom, c, '-', CellColor::Cyan);
+    }
+    put(top, 2 * width, '+', CellColor::Cyan);
+    put(bottom, 2 * width, '+', CellColor::Cyan);
+
+    const auto clearable = [&](int y) { return (frame.clearable_rows >> y) & 1; };
+    for (int y = height - 1; y >= 0; --y) {
+        const int row = top + height - y;
+        const CellColor line_color = clearable(y) ? CellColor::Yellow : CellColor::None;
+        const char* glyphs = frame.glyphs.data() + static_cast<size_t>(y) * width;
+        put(row, 0, '|', CellColor::Cyan);
+        for (int x = 0; x < width; ++x) {
+            put(row, 1 + 2 * x, glyphs[x], line_color);
+        }
+        put(row, 2 * width + 1, '|', CellColor::Cyan);
+    }
+    if (frame.rotation) {
+        for (const auto& pos : frame.rotation->occupied) {
+            const int x = frame.x_offset + pos.x;
+            const int y = frame.y_offset + pos.y;
+            if (x >= 0 && x < width && y >= 0 && y < height) {
+                put(top + height - y, 1 + 2 * x, 'X', clearable(y) ? CellColor::Yellow : CellColor::Green);
+            }
+        }
+    }
+
+    // Column coordinates
+    col = 2;
+    for (int x = 0; x < width; ++x) {
+        col = putNumber(bottom + 1, col, x) + 1;
+    }
+}
+
+void FrameRenderer::diff()
+{
+    out_.clear();
+    if (!has_previous_) {
+        out_ += "\033[H\033[2J"; // Home and clear: every cell is now blank
+        previous_.assign(frame_.size(), Cell {});
+        has_previous_ = true;
+    }
+
+    // The terminal's colour and cursor position while emitting
+    CellColor color = CellColor::None;
+    int cursor_row = -1;
+    int cursor_col = -1;
+    for (int row = 0; row < rows_; ++row) {
+        const size_t base = static_cast<size_t>(row) * cols_;
+        // Most rows don't change between pieces
+        if (std::memcmp(&frame_[base], &previous_[base], sizeof(Cell) * cols_) == 0) continue;
+        for (int col = 0; col < cols_; ++col) {
+            const Cell& cell = frame_[base + col];
+            if (cell == previous_[base + col]) continue;
+            if (row == cursor_row && col > cursor_col && col - cursor_col <= k_max_rewrite_gap
+                && std::all_of(&frame_[base + cursor_col], &frame_[base + col], [&](const Cell& c) { return c.color == color; })) {
+                // Rewriting a few unchanged cells is shorter than a cursor move
+                for (int c = cursor_col; c < col; ++c) out_ += frame_[base + c].glyph;
+            } else if (row != cursor_row || col != cursor_col) {
+                appendCursorMove(out_, row + 1, col + 1);
+            }
+            if (cell.color != color) {
+                switch (cell.color) {
+                case CellColor::Cyan: out_ += CYAN_COLOR; break;
+                case CellColor::Green: out_ += GREEN_COLOR; break;
+                case CellColor::Yellow: out_ += YELLOW_COLOR; break;
+                default: out_ += RESET_COLOR; break;
+                }
+                color = cell.color;
+            }
+            out_ += cell.glyph;
+            cursor_row = row;
+            cursor_col = col + 1;
+        }
+    }
+    if (color != CellColor::None) out_ += RESET_COLOR;
+    if (cursor_row >= 0) {
+        appendCursorMove(out_, rows_ + 1, 1); // Park the cursor below the frame
+    }
+    previous_.swap(frame_);
+}
+
+void FrameRenderer::flush()
+{
+    if (out_.empty()) return;
+    std::cout.flush(); // Anything printed before the frame goes first
+    const char* data = out_.data();
+    size_t left = out_.size();
+    while (left > 0) {
+        ssize_t written = ::write(fd_, data, left);
+        if (written < 0) {
+            if (errno == EINTR) continue;
+            return; // Terminal gone: drop the frame
+        }
+        data += written;
+        left -= static_cast<size_t>(written);
+    }
+}
+
+// --- LiveRenderer ---
+
+LiveRenderer::LiveRenderer(int fps, int fd)
+    : renderer_(fd)
+    , interval_(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / std::max(fps, 1))))
+    , thread_(&LiveRenderer::run, this)
+{
+}
+
+LiveRenderer::~LiveRenderer()
+{
+    stop();
+}
+
+void LiveRenderer::publish(const Game& game, const BlockStatus& action, int y_offset, long long pieces)
+{
+    captureFrame(game, action, y_offset, pieces, mailbox_.back());
+    mailbox_.publish();
+}
+
+void LiveRenderer::stop()
+{
+    if (!thread_.joinable()) return;
+    stopping_.store(true, std::memory_order_release);
+    thread_.join();
+}
+
+void LiveRenderer::run()
+{
+    auto next_frame = std::chrono::steady_clock::now();
+    while (!stopping_.load(std::memory_order_acquire)) {
+        if (mailbox_.take()) {
+            renderer_.render(mailbox_.front());
+        }
+        // Fixed ticks; after a slow frame (e.g. a blocked terminal) restart from now instead of catching up
+        next_frame = std::max(next_frame + interval_, std::chrono::steady_clock::now());
+        std::this_thread::sleep_until(next_frame);
+    }
+    if (mailbox_.take()) {
+        renderer_.render(mailbox_.front()); // The final position
+    }
+}
@@ -1,9 +1,16 @@
 #ifndef VISUALIZE_H
 #define VISUALIZE_H
 
+#include "mailbox.h"
 #include "models.h" // Includes Game, Board, BlockStatus, Block, Position, Size
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
 #include <vector>
 #include <string>
+#include <unistd.h> // STDOUT_FILENO
 
 // --- Color Helper Declarations ---
 std::string cyan(const std::string& text);
@@ -33,5 +40,99 @@ void visualizeGame(const Game& game, const BlockStatus& action, int y_offset, bo
 // Visualizes the calculated DBT feature values.
 void visualizeDbtFeature(const std::vector<int>& features);
 
+// What one frame of the live view shows, copied out of the game so another thread can draw it.
+// Fixed size (no pointers into the Board), so capturing never allocates.
+struct FrameSnapshot {
+    static constexpr int k_max_width = 32; // Board's limits
+    static constexpr int k_max_rows = 64;
+
+    int width = 0;
+    int height = 0; // Logical rows
+    int score = 0;
+    long long pieces = 0; // Placed so far
+    std::array<const Block*, 2> preview {}; // upcoming_blocks[0..1]
+    const BlockRotation* rotation = nullptr; // Action just played, null if none
+    int x_offset = 0;
+    int y_offset = 0;
+    bool has_assessment = false;
+    double assessment = 0.0;
+    std::uint64_t clearable_rows = 0; // Bit y set if canClearLine(y)
+    std::array<char, k_max_width * k_max_rows> glyphs {}; // Cell (x, y) at y * width + x, ' ' if empty
+};
+
+// Fills `out` from `game` after `action` landed at `y_offset`
+void captureFrame(const Game& game, const BlockStatus& action, int y_offset, long long pieces, FrameSnapshot& out);
+
+// Live view of a running game on an ANSI terminal (tetris_test -v). Each frame shows the
+// same content as visualizeGame(..., true). It is composed into a reusable cell buffer and
+// compared with the previous frame. Only the cells that changed are emitted, as cursor moves
+// and characters, and the whole update is one write() to `fd`. Nothing is allocated per cell
+// or per frame once the buffers have grown. The renderer owns the screen: don't print to the
+// same terminal between frames, or call invalidate() afterwards.
+class FrameRenderer {
+public:
+    explicit FrameRenderer(int fd = STDOUT_FILENO);
+
+    void render(const FrameSnapshot& frame);
+    // Draws `game` after `action` landed at `y_offset`; `pieces` is the number placed so far
+    void render(const Game& game, const BlockStatus& action, int y_offset, long long pieces);
+    // The next render() clears the screen and redraws every cell
+    void invalidate() { has_previous_ = false; }
+
+private:
+    enum class CellColor : std::uint8_t { None, Cyan, Green, Yellow };
+    struct Cell {
+        char glyph = ' ';
+        CellColor color = CellColor::None;
+        bool operator==(const Cell& other) const { return glyph == other.glyph && color == other.color; }
+    };
+    static_assert(sizeof(Cell) == 2, "Rows of cells are compared with memcmp");
+
+    void compose(const FrameSnapshot& frame);
+    // Write `text` / `value` from (row, col), clipped to the frame width; return the column after it
+    int put(int row, int col, const char* text, CellColor color = CellColor::None);
+    int putNumber(int row, int col, long long value);
+    void put(int row, int col, char glyph, CellColor color = CellColor::None);
+    // Appends the escape sequences for the cells that differ from previous_ to out_
+    void diff();
+    void flush();
+
+    int fd_;
+    int rows_ = 0;
+    int cols_ = 0;
+    std::vector<Cell> frame_;
+    std::vector<Cell> previous_;
+    bool has_previous_ = false;
+    std::string out_;
+    FrameSnapshot snapshot_; // For render(const Game&, ...)
+};
+
+// Runs a FrameRenderer on its own thread at a fixed frame rate. The game thread publish()es
+// a snapshot after every piece into a wait-free mailbox and carries on; the render thread
+// draws the newest one each tick, skipping the ones in between. So a fast game never waits
+// for the terminal, and the terminal only receives `fps` frames per second.
+class LiveRenderer {
+public:
+    explicit LiveRenderer(int fps, int fd = STDOUT_FILENO);
+    ~LiveRenderer(); // stop()
+    LiveRenderer(const LiveRenderer&) = delete;
+    LiveRenderer& operator=(const LiveRenderer&) = delete;
+
+    // Game thread: captures the frame (a copy of the board, no allocation) and returns
+    void publish(const Game& game, const BlockStatus& action, int y_offset, long long pieces);
+    // Draws the last published frame and joins the render thread; later calls do nothing.
+    // Call it before printing to the terminal again.
+    void stop();
+
+private:
+    void run();
+
+    FrameRenderer renderer_;
+    LatestValueMailbox<FrameSnapshot> mailbox_;
+    std::chrono::steady_clock::duration interval_;
+    std::atomic<bool> stopping_ { false };
+    std::thread thread_;
+};
+
 
 #endif // VISUALIZE_H
\ No newline at end of file